@@ -0,0 +1,176 @@
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <random>
+#include <string>
+#include <functional>
+
+#include "Settings.h"
+#include "Simulation.h"
+#include "Timer.h"
+#include "Random.h"
+#include "Renderer.h"
+#include "FrameSnapshot.h"
+
+// Stage benchmark: fixed-seed scenarios sweeping particle count and RENDER_GRAVITY_RADIUS,
+// every stage of a step timed on its own. Settings other than the radius keep their Settings.cpp defaults.
+// Usage: grav_bench [max particle count] [threads, 0 = all hardware threads] [grid side in pixels, default GRID_WIDTH]
+// Output: one semicolon-separated line per scenario and stage, us_per_call is the mean over reps.
+
+namespace {
+
+const unsigned int SEED = 42;
+const int COUNTS[] = { 10, 100, 1000, 10000, 100000 };
+const double RADII[] = { 5, 25, 100 };
+const double T = 0.01;
+const double TK = 1.0;
+const long long MIN_STAGE_NS = 200000000;  // repeat a stage until it ran this long
+const int MAX_REPS = 1000;
+const int ANALYTIC_MAX_COUNT = 10000;
+const size_t HISTORY_CAPACITY = 16;  // the full 1000 would be 1.6 GB of rings at 100k particles
+
+
+// Same spawn boxes as main: A1/A2 packed near the centre, one A3 in ten spread out
+void spawn(ParticleSystem& peaks, int count) {
+    seedRandom(SEED);  // spin is drawn from the shared engine
+    std::mt19937 gen(SEED);
+    std::uniform_real_distribution<> packed(-5.0, -4.0);
+    std::uniform_real_distribution<> spread(-10.0, 10.0);
+    std::uniform_real_distribution<> velocity(-0.1, 0.1);
+
+    int type3 = count >= 10 ? count / 10 : 1;
+    for (int i = 0; i < count; i++) {
+        if (i < type3) {
+            peaks.add(Particle(TYPE_MASS[ParticleType::A3], TYPE_WIDTH[ParticleType::A3], spread(gen), spread(gen), 0, 0, ParticleType::A3));
+        } else if (i % 2 == 0) {
+            peaks.add(Particle(TYPE_MASS[ParticleType::A1], TYPE_WIDTH[ParticleType::A1], packed(gen), packed(gen), velocity(gen), velocity(gen), ParticleType::A1));
+        } else {
+            peaks.add(Particle(TYPE_MASS[ParticleType::A2], TYPE_WIDTH[ParticleType::A2], packed(gen), packed(gen), velocity(gen), velocity(gen), ParticleType::A2));
+        }
+    }
+    peaks.groupByType();  // every stage below sees the bucketed layout generateData keeps
+}
+
+// Runs stage at least once and until MIN_STAGE_NS passed, returns microseconds per call
+double measure(const std::function<void()>& stage, int& reps) {
+    Timer timer;
+    reps = 0;
+    do {
+        stage();
+        ++reps;
+    } while (timer.elapsedNanoseconds() < MIN_STAGE_NS && reps < MAX_REPS);
+    return timer.elapsedNanoseconds() / 1000.0 / reps;
+}
+
+void print(int count, double radius, size_t threads, const char* stage, int reps, double microseconds) {
+    std::cout << count << ";" << radius << ";" << threads << ";" << stage << ";" << reps << ";" << microseconds << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int maxCount = argc > 1 ? std::stoi(argv[1]) : 100000;
+    size_t threadCount = argc > 2 ? static_cast<size_t>(std::stoi(argv[2])) : 0;
+    unsigned int gridSide = argc > 3 ? static_cast<unsigned int>(std::stoi(argv[3])) : static_cast<unsigned int>(GRID_WIDTH);
+
+    FieldGrid grid(gridSide, gridSide, GRID_SCALE);
+
+    ThreadPool pool(threadCount);
+    FieldGenerator field;
+    Telemetry telemetry;  // never started, record() is a no-op
+
+    std::cout << "particles;radius;threads;stage;reps;us_per_call" << std::endl;
+    for (int count : COUNTS) {
+        if (count > maxCount) break;
+        for (double radius : RADII) {
+            RENDER_GRAVITY_RADIUS = radius;
+
+            ParticleSystem peaks(HISTORY_CAPACITY);
+            spawn(peaks, count);
+            QuadTree qtree(Boundary(0, 0, grid.worldWidth(), grid.worldHeight()));
+            int reps = 0;
+            double time = 0.0;
+
+            // g0: one point per call, sampled over the window around the centre
+            const int SAMPLES = 64;
+            time = measure([&]() {
+                volatile double sink = 0.0;
+                for (int s = 0; s < SAMPLES; ++s) {
+                    sink = sink + peaks.g0(-radius + 2.0 * radius * s / SAMPLES, radius - 2.0 * radius * s / SAMPLES, T);
+                }
+            }, reps);
+            print(count, radius, pool.size(), "g0", reps * SAMPLES, time / SAMPLES);
+
+            time = measure([&]() {
+                qtree.build(peaks);
+                qtree.computeMassDistribution(T);
+            }, reps);
+            print(count, radius, 1, "quadtree_build", reps, time);
+
+            // quadtree_query: one range query of the render radius per call, around a strided sample of particles
+            // (all of them would be quadratic, the packed particles all fall into each other's range)
+            const size_t QUERIES = 256;
+            size_t stride = peaks.size() > QUERIES ? peaks.size() / QUERIES : 1;
+            size_t queries = (peaks.size() + stride - 1) / stride;
+            std::vector<unsigned int> found;
+            time = measure([&]() {
+                for (size_t p = 0; p < peaks.size(); p += stride) {
+                    found.clear();
+                    qtree.query(Boundary(peaks.x[p], peaks.y[p], radius, radius), found);
+                }
+            }, reps);
+            print(count, radius, 1, "quadtree_query", static_cast<int>(reps * queries), time / queries);
+
+            // field_full rebuilds every tile, field_static is the cached grid with no particle moved
+            time = measure([&]() {
+                field.invalidate();
+                field.generate(grid, peaks, radius, SEPARABLE_FIELD == 1, T, FIELD_TOLERANCE, pool);
+            }, reps);
+            print(count, radius, pool.size(), "field_full", reps, time);
+
+            time = measure([&]() {
+                field.generate(grid, peaks, radius, SEPARABLE_FIELD == 1, T, FIELD_TOLERANCE, pool);
+            }, reps);
+            print(count, radius, pool.size(), "field_static", reps, time);
+
+            // updatePosition: one serial sweep over every particle against the current tree and field
+            time = measure([&]() {
+                for (size_t p = 0; p < peaks.size(); ++p) {
+                    peaks.updatePosition(p, qtree, THETA, T, k, grid, false, TK, telemetry);
+                }
+                peaks.swapBuffers();
+            }, reps);
+            print(count, radius, 1, "updatePosition", reps, time);
+
+            // Same sweep with the closed-form gradient, O(N^2) so only up to ANALYTIC_MAX_COUNT particles
+            if (count <= ANALYTIC_MAX_COUNT) {
+                time = measure([&]() {
+                    for (size_t p = 0; p < peaks.size(); ++p) {
+                        peaks.updatePosition(p, qtree, THETA, T, k, grid, true, TK, telemetry);
+                    }
+                    peaks.swapBuffers();
+                }, reps);
+                print(count, radius, 1, "updatePosition_analytic", reps, time);
+            }
+
+            time = measure([&]() {
+                generateData(T, grid, peaks, qtree, field, pool, telemetry, TK, true);
+            }, reps);
+            print(count, radius, pool.size(), "generateData", reps, time);
+
+            FrameSnapshot frame;
+            time = measure([&]() {
+                frame.capture(grid, field.maxValue(), SHOW_GRAV == 1, peaks, static_cast<size_t>(TAIL_CUTOFF), 0, TK);
+            }, reps);
+            print(count, radius, 1, "capture", reps, time);
+
+            // Renderer::draw is the CPU side of a frame, present() needs a display
+            Renderer renderer(grid);
+            time = measure([&]() {
+                renderer.draw(frame);
+            }, reps);
+            print(count, radius, 1, "render", reps, time);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <random>
+#include <string>
+#include <algorithm>
+
+#include "ParticleSystem.h"
+#include "GaussianKernel.h"
+#include "SeparableField.h"
+#include "Timer.h"
+
+// Micro-benchmark: SIMD Gaussian row kernel and separable factor tables against the scalar valueAt/g0 path.
+// Usage: kernel_bench [particle count] [window radius]
+int main(int argc, char** argv) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 7;
+    int radius = argc > 2 ? std::stoi(argv[2]) : 100;
+    const double t = 0.1;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> position(-20.0, 20.0);
+    std::uniform_real_distribution<> width(5.0, 100.0);
+    ParticleSystem peaks;
+    for (int i = 0; i < count; i++) {
+        peaks.add(Particle(20, width(gen), position(gen), position(gen), ::A1));
+    }
+
+    const int side = 2 * radius + 1;
+    std::vector<double> scalar(side * side);
+    std::vector<double> simd(side * side);
+    std::vector<double> separable(side * side);
+
+    Timer scalarTimer;
+    for (int i = 0; i < side; ++i) {
+        for (int j = 0; j < side; ++j) {
+            scalar[i * side + j] = peaks.g0(i - radius + 0.3, j - radius + 0.7, t);
+        }
+    }
+    long long scalarTime = scalarTimer.elapsed();
+
+    Timer simdTimer;
+    for (int i = 0; i < side; ++i) {
+        peaks.g0Row(i - radius + 0.3, -radius + 0.7, 1.0, side, t, &simd[i * side]);
+    }
+    long long simdTime = simdTimer.elapsed();
+
+    Timer separableTimer;
+    SeparableWindow window;
+    window.compute(peaks, -radius + 0.3, -radius + 0.7, 1.0, side, side, t);
+    for (int i = 0; i < side; ++i) {
+        window.g0Row(i, 0, side, &separable[i * side]);
+    }
+    long long separableTime = separableTimer.elapsed();
+
+    double maxError = 0.0;
+    double separableError = 0.0;
+    for (int p = 0; p < side * side; ++p) {
+        if (scalar[p] != 0.0) {
+            maxError = std::max(maxError, std::abs(simd[p] - scalar[p]) / std::abs(scalar[p]));
+            separableError = std::max(separableError, std::abs(separable[p] - scalar[p]) / std::abs(scalar[p]));
+        }
+    }
+
+    double expError = 0.0;
+    for (double x = -708.0; x <= 0.0; x += 0.00137) {
+        expError = std::max(expError, std::abs(fastExp(x) - exp(x)) / exp(x));
+    }
+
+    std::cout << "particles;pixels;scalar_us;simd_us;speedup;max_rel_error;fast_exp_max_rel_error;separable_us;separable_speedup;separable_max_rel_error" << std::endl;
+    std::cout << count << ";" << side * side << ";" << scalarTime << ";" << simdTime << ";"
+              << (simdTime > 0 ? static_cast<double>(scalarTime) / simdTime : 0.0) << ";"
+              << maxError << ";" << expError << ";" << separableTime << ";"
+              << (separableTime > 0 ? static_cast<double>(scalarTime) / separableTime : 0.0) << ";"
+              << separableError << std::endl;
+    return 0;
+}
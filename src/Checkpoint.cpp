@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Checkpoint.h"
+#include "Settings.h"
+#include "Random.h"
+#include "Profiler.h"
+
+namespace {
+
+// Settings that change the physics travel with the checkpoint; window, output and run-length settings
+// keep coming from properties.txt so a resumed run can be driven differently
+struct SettingSlot {
+    const char* name;
+    double* value;
+};
+
+const SettingSlot PHYSICS_SETTINGS[] = {
+    { "TIME_SCALE", &TIME_SCALE }, { "k", &k },
+    { "RENDER_GRAVITY_RADIUS", &RENDER_GRAVITY_RADIUS }, { "THETA", &THETA }, { "SEPARABLE_FIELD", &SEPARABLE_FIELD },
+    { "FIELD_TOLERANCE", &FIELD_TOLERANCE }, { "ANALYTIC_GRADIENT", &ANALYTIC_GRADIENT }, { "SEED", &SEED },
+    { "GRID_WIDTH", &GRID_WIDTH }, { "GRID_HEIGHT", &GRID_HEIGHT }, { "GRID_SCALE", &GRID_SCALE },
+};
+
+// The double columns, in file order
+template <typename System>
+auto doubleColumns(System& particles) -> std::array<decltype(&particles.x), 7> {
+    return {{ &particles.x, &particles.y, &particles.vx, &particles.vy, &particles.A, &particles.W, &particles.lockedMagnitude }};
+}
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+template <typename T>
+void appendBlock(std::vector<char>& out, const T* data, size_t count) {
+    size_t offset = out.size();
+    out.resize(offset + padded(count * sizeof(T)), 0);
+    if (count > 0) std::memcpy(&out[offset], data, count * sizeof(T));
+}
+
+// Bounds-checked walk over the mapped file, every block is read where it lies
+class BlockReader {
+public:
+    BlockReader(const char* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    const T* next(size_t count) {
+        if (count > (size - offset) / sizeof(T)) return nullptr;
+        size_t bytes = padded(count * sizeof(T));
+        if (bytes > size - offset) return nullptr;
+        const T* block = reinterpret_cast<const T*>(data + offset);
+        offset += bytes;
+        return block;
+    }
+
+private:
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+};
+
+// Read-only view of the whole file: mmap where there is one, a plain read elsewhere
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+#if defined(_WIN32)
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file) return;
+        copy.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(copy.data(), copy.size())) return;
+        bytes = copy.data();
+        length = copy.size();
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                bytes = static_cast<const char*>(mapped);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+        ::close(fd);  // the mapping keeps the file alive
+#endif
+    }
+
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (bytes) ::munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    std::vector<char> copy;
+#endif
+};
+
+} // namespace
+
+void CheckpointState::capture(const ParticleSystem& particles, const StepClock& clock, long long step, unsigned int seed) {
+    PROFILE_ZONE("checkpoint/capture");
+    size_t count = particles.size();
+    size_t capacity = particles.history.capacity();
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "GRAVCKP", 8);
+    header.version = CHECKPOINT_VERSION;
+    header.particleCount = count;
+    header.historyCapacity = capacity;
+    header.step = step;
+    header.tk = clock.tk;
+    header.t = clock.t;
+    header.oscillating = clock.oscillating ? 1 : 0;
+    header.increasing = clock.increasing ? 1 : 0;
+    header.seed = seed;
+
+    settings.clear();
+    auto addSetting = [this](const char* name, double value) {
+        CheckpointSetting setting;
+        std::memset(&setting, 0, sizeof(setting));
+        std::strncpy(setting.name, name, sizeof(setting.name) - 1);
+        setting.value = value;
+        settings.push_back(setting);
+    };
+    for (const SettingSlot& slot : PHYSICS_SETTINGS) {
+        addSetting(slot.name, *slot.value);
+    }
+    // TYPE<n>_COUNT, MASS<n> and W<n> of every type
+    for (int type = 0; type < PARTICLE_TYPE_COUNT; ++type) {
+        for (const std::string& key : typeSettingKeys(static_cast<ParticleType>(type))) {
+            addSetting(key.c_str(), *typeSetting(key));
+        }
+    }
+    header.settingCount = static_cast<std::uint32_t>(settings.size());
+
+    std::ostringstream rng;
+    rng << randomEngine();
+    rngState = rng.str();
+    header.rngStateSize = rngState.size();
+
+    particleData.clear();
+    for (const std::vector<double>* column : doubleColumns(particles)) {
+        appendBlock(particleData, column->data(), count);
+    }
+
+    std::vector<std::int32_t> ints(count);
+    for (size_t p = 0; p < count; ++p) ints[p] = static_cast<std::int32_t>(particles.type[p]);
+    appendBlock(particleData, ints.data(), count);
+    for (size_t p = 0; p < count; ++p) ints[p] = static_cast<std::int32_t>(particles.spin[p]);
+    appendBlock(particleData, ints.data(), count);
+    appendBlock(particleData, reinterpret_cast<const std::uint8_t*>(particles.isLocked.data()), count);
+
+    std::vector<std::uint64_t> historyCount(count);
+    std::vector<double> history(count * capacity * 2, 0.0);
+    for (size_t p = 0; p < count; ++p) {
+        HistoryView view = particles.history.view(p);
+        historyCount[p] = view.size();
+        double* out = &history[p * capacity * 2];
+        for (size_t i = view.size(); i-- > 0;) {  // oldest first
+            *out++ = view[i].first;
+            *out++ = view[i].second;
+        }
+    }
+    appendBlock(particleData, historyCount.data(), count);
+    appendBlock(particleData, history.data(), history.size());
+}
+
+bool writeCheckpoint(const CheckpointState& state, const std::string& filename) {
+    std::string temporary = filename + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open checkpoint file " << temporary << std::endl;
+        return false;
+    }
+
+    std::vector<char> head;
+    appendBlock(head, &state.header, 1);
+    appendBlock(head, state.settings.data(), state.settings.size());
+    appendBlock(head, state.rngState.data(), state.rngState.size());
+    bool ok = std::fwrite(head.data(), 1, head.size(), file) == head.size()
+           && std::fwrite(state.particleData.data(), 1, state.particleData.size(), file) == state.particleData.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write checkpoint file " << temporary << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        std::cerr << "Failed to replace checkpoint " << filename << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadCheckpoint(const std::string& filename, ParticleSystem& particles, StepClock& clock, long long& step, unsigned int& seed) {
+    MappedFile file(filename);
+    if (!file.data()) {
+        std::cerr << "Failed to open checkpoint file " << filename << std::endl;
+        return false;
+    }
+    if (particles.size() != 0) {
+        std::cerr << "Checkpoint can only be loaded into an empty particle system." << std::endl;
+        return false;
+    }
+
+    BlockReader reader(file.data(), file.size());
+    const CheckpointHeader* header = reader.next<CheckpointHeader>(1);
+    if (!header || std::memcmp(header->magic, "GRAVCKP", 8) != 0) {
+        std::cerr << filename << " is not a checkpoint file." << std::endl;
+        return false;
+    }
+    if (header->version != CHECKPOINT_VERSION) {
+        std::cerr << "Checkpoint version " << header->version << " is not supported (expected " << CHECKPOINT_VERSION << ")." << std::endl;
+        return false;
+    }
+
+    size_t count = header->particleCount;
+    size_t capacity = header->historyCapacity;
+    // Both come from the file: every particle takes at least its 7 doubles, and count * capacity * 2 below
+    // must not wrap around to a size the reader would accept
+    if (count > file.size() / (7 * sizeof(double)) || (capacity != 0 && count > (SIZE_MAX / 2) / capacity)) {
+        std::cerr << "Checkpoint file " << filename << " has an invalid particle count " << count
+                  << " or history capacity " << capacity << "." << std::endl;
+        return false;
+    }
+    const CheckpointSetting* settings = reader.next<CheckpointSetting>(header->settingCount);
+    const char* rngState = reader.next<char>(header->rngStateSize);
+    const double* columns[7];
+    for (const double*& column : columns) column = reader.next<double>(count);  // doubleColumns order
+    const std::int32_t* type = reader.next<std::int32_t>(count);
+    const std::int32_t* spin = reader.next<std::int32_t>(count);
+    const std::uint8_t* isLocked = reader.next<std::uint8_t>(count);
+    const std::uint64_t* historyCount = reader.next<std::uint64_t>(count);
+    const double* history = reader.next<double>(count * capacity * 2);
+    if (!settings || !rngState || !columns[6] || !type || !spin || !isLocked || !historyCount || !history) {
+        std::cerr << "Checkpoint file " << filename << " is truncated." << std::endl;
+        return false;
+    }
+    for (size_t p = 0; p < count; ++p) {
+        if (type[p] < 0 || type[p] >= PARTICLE_TYPE_COUNT) {
+            std::cerr << "Checkpoint file " << filename << " has a particle of unknown type " << type[p] << "." << std::endl;
+            return false;
+        }
+        if (spin[p] != LEFT && spin[p] != RIGHT) {
+            std::cerr << "Checkpoint file " << filename << " has a particle of unknown spin " << spin[p] << "." << std::endl;
+            return false;
+        }
+    }
+
+    // Unknown names are skipped, settings added after the checkpoint was written keep their values
+    for (size_t s = 0; s < header->settingCount; ++s) {
+        std::string name(settings[s].name, strnlen(settings[s].name, sizeof(settings[s].name)));
+        if (double* perType = typeSetting(name)) *perType = settings[s].value;
+        for (const SettingSlot& slot : PHYSICS_SETTINGS) {
+            if (name == slot.name) *slot.value = settings[s].value;
+        }
+    }
+
+    std::istringstream rng(std::string(rngState, header->rngStateSize));
+    rng >> randomEngine();
+    seed = header->seed;
+
+    clock.tk = header->tk;
+    clock.t = header->t;
+    clock.oscillating = header->oscillating != 0;
+    clock.increasing = header->increasing != 0;
+    step = header->step;
+
+    std::array<std::vector<double>*, 7> targets = doubleColumns(particles);
+    for (size_t c = 0; c < targets.size(); ++c) {
+        targets[c]->assign(columns[c], columns[c] + count);
+    }
+    particles.type.resize(count);
+    particles.spin.resize(count);
+    particles.isLocked.resize(count);
+    particles.invTwoWSquared.resize(count);
+    std::vector<HistoryBuffer::Position> initial;
+    for (size_t p = 0; p < count; ++p) {
+        particles.type[p] = static_cast<ParticleType>(type[p]);
+        particles.spin[p] = static_cast<Spin>(spin[p]);
+        particles.isLocked[p] = static_cast<char>(isLocked[p]);
+        particles.invTwoWSquared[p] = 1.0 / (2 * particles.W[p] * particles.W[p]);  // as in ParticleSystem::add
+
+        const double* entries = &history[p * capacity * 2];
+        initial.resize(std::min<size_t>(historyCount[p], capacity));
+        for (size_t i = 0; i < initial.size(); ++i) {
+            initial[i] = HistoryBuffer::Position(entries[2 * i], entries[2 * i + 1]);
+        }
+        particles.history.addParticle(initial);
+    }
+
+    particles.nextX = particles.x;
+    particles.nextY = particles.y;
+    particles.nextVX = particles.vx;
+    particles.nextVY = particles.vy;
+    particles.nextIsLocked = particles.isLocked;
+    particles.nextLockedMagnitude = particles.lockedMagnitude;
+    particles.groupByType();
+    return true;
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    stop();
+}
+
+void CheckpointWriter::start(const std::string& filename) {
+    this->filename = filename;
+    running = true;
+    writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+void CheckpointWriter::submit(CheckpointState& state) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(waiting, state);
+        hasWaiting = true;
+    }
+    wake.notify_one();
+}
+
+void CheckpointWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+void CheckpointWriter::writerLoop() {
+    CheckpointState writing;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return hasWaiting || !running; });
+            if (!hasWaiting) return;  // stopped with nothing left
+            std::swap(writing, waiting);
+            hasWaiting = false;
+        }
+        writeCheckpoint(writing, filename);
+    }
+}
@@ -0,0 +1,203 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "FieldGenerator.h"
+#include "GaussianKernel.h"
+#include "Profiler.h"
+
+namespace {
+
+int tilesFor(unsigned int pixels) {
+    return static_cast<int>((pixels + FieldGenerator::TILE_SIZE - 1) / FieldGenerator::TILE_SIZE);
+}
+
+// Window indices [first, last) whose pixel along one axis, static_cast<int>((start + a * step) / step + half)
+// as in FieldGrid::pixelX/pixelY, lies in [lo, hi)
+void windowRange(double start, double step, double half, size_t side, int lo, int hi, size_t& first, size_t& last) {
+    auto pixelOf = [&](size_t a) { return static_cast<int>((start + a * step) / step + half); };
+    double guess = std::floor(lo - start / step - half) - 1;
+    first = guess > 0 ? std::min(static_cast<size_t>(guess), side) : 0;
+    while (first < side && pixelOf(first) < lo) ++first;
+    last = first;
+    while (last < side && pixelOf(last) < hi) ++last;
+}
+
+} // namespace
+
+template <typename Scalar>
+void FieldGenerator::generate(BasicFieldGrid<Scalar>& grid, const ParticleSystem& peaks, double radius, bool separable, double t, double tolerance, ThreadPool& pool) {
+    windows.resize(pool.size());
+    // Separable factors are tabulated in double whatever the grid holds, so their terms reach as far as double ones
+    double cutoff = separable ? GaussianCutoff<double>::exponent : GaussianCutoff<Scalar>::exponent;
+    markDirty(grid, peaks, radius, separable, tolerance, cutoff);
+
+    dirtyTiles.clear();
+    for (size_t tile = 0; tile < dirty.size(); ++tile) {
+        if (dirty[tile]) dirtyTiles.push_back(tile);
+    }
+    pool.parallelFor(dirtyTiles.size(), [&](size_t index, size_t worker) {
+        generateTile(dirtyTiles[index], worker, grid, peaks, radius, separable, t);
+    });
+    std::fill(dirty.begin(), dirty.end(), 0);
+    max = *std::max_element(tileMax.begin(), tileMax.end());
+}
+
+template void FieldGenerator::generate<double>(BasicFieldGrid<double>&, const ParticleSystem&, double, bool, double, double, ThreadPool&);
+template void FieldGenerator::generate<float>(BasicFieldGrid<float>&, const ParticleSystem&, double, bool, double, double, ThreadPool&);
+
+void FieldGenerator::invalidate() {
+    anchorX.clear();
+    anchorY.clear();
+}
+
+double FieldGenerator::maxValue() const {
+    return max;
+}
+
+size_t FieldGenerator::lastRecomputed() const {
+    return dirtyTiles.size();
+}
+
+void FieldGenerator::markDirty(const GridGeometry& grid, const ParticleSystem& peaks, double radius, bool separable, double tolerance, double cutoff) {
+    bool sameGrid = grid.width() == lastWidth && grid.height() == lastHeight && grid.scale() == lastScale;
+    if (!sameGrid || anchorX.size() != peaks.size() || radius != lastRadius || separable != lastSeparable) {
+        tilesX = tilesFor(grid.width());
+        tilesY = tilesFor(grid.height());
+        size_t tiles = static_cast<size_t>(tilesX) * tilesY;
+        tileMax.assign(tiles, 0.0);
+        dirty.assign(tiles, 1);
+        anchorX = peaks.x;
+        anchorY = peaks.y;
+        lastRadius = radius;
+        lastSeparable = separable;
+        lastWidth = grid.width();
+        lastHeight = grid.height();
+        lastScale = grid.scale();
+        return;
+    }
+
+    // tolerance and the one pixel margin are in pixels, positions in world units
+    double drift = tolerance * grid.scale();
+    for (size_t p = 0; p < peaks.size(); ++p) {
+        double dx = peaks.x[p] - anchorX[p];
+        double dy = peaks.y[p] - anchorY[p];
+        if ((dx == 0.0 && dy == 0.0) || dx * dx + dy * dy < drift * drift) continue;
+
+        // The window decides which pixels get computed, the Gaussian which values change; its terms are
+        // exactly 0 once (d / W)^2 / 2 passes the cutoff. Tiles rebuilt meanwhile may hold any position within
+        // tolerance of the anchor, so that margin is covered too.
+        double influence = std::sqrt((cutoff + 1.0) / peaks.invTwoWSquared[p]);
+        double reach = std::max(radius, influence) + grid.scale() + drift;
+        markSquare(grid, anchorX[p], anchorY[p], reach);
+        markSquare(grid, peaks.x[p], peaks.y[p], reach);
+        anchorX[p] = peaks.x[p];
+        anchorY[p] = peaks.y[p];
+    }
+}
+
+void FieldGenerator::markSquare(const GridGeometry& grid, double x, double y, double reach) {
+    double scale = grid.scale();
+    double pixels[2] = { static_cast<double>(grid.width()), static_cast<double>(grid.height()) };
+    double lo[2] = { std::floor((x - reach) / scale + pixels[0] / 2.0), std::floor((y - reach) / scale + pixels[1] / 2.0) };
+    double hi[2] = { std::floor((x + reach) / scale + pixels[0] / 2.0), std::floor((y + reach) / scale + pixels[1] / 2.0) };
+    int first[2], last[2];
+    for (int axis = 0; axis < 2; ++axis) {
+        if (hi[axis] < 0 || lo[axis] >= pixels[axis]) return;  // square entirely off the grid
+        first[axis] = static_cast<int>(std::max(lo[axis], 0.0)) / TILE_SIZE;
+        last[axis] = static_cast<int>(std::min(hi[axis], pixels[axis] - 1.0)) / TILE_SIZE;
+    }
+    for (int ti = first[0]; ti <= last[0]; ++ti) {
+        for (int tj = first[1]; tj <= last[1]; ++tj) {
+            dirty[ti * tilesY + tj] = 1;
+        }
+    }
+}
+
+template <typename Scalar>
+void FieldGenerator::generateTile(size_t tile, size_t worker, BasicFieldGrid<Scalar>& grid, const ParticleSystem& peaks, double radius, bool separable, double t) {
+    PROFILE_ZONE("field/tile");
+    int i0 = static_cast<int>(tile / tilesY) * TILE_SIZE;
+    int j0 = static_cast<int>(tile % tilesY) * TILE_SIZE;
+    int i1 = std::min(i0 + TILE_SIZE, static_cast<int>(grid.width()));
+    int j1 = std::min(j0 + TILE_SIZE, static_cast<int>(grid.height()));
+
+    for (int i = i0; i < i1; ++i) {
+        std::fill(grid.column(i) + j0, grid.column(i) + j1, Scalar(0));
+    }
+    bool computed[TILE_SIZE][TILE_SIZE] = { false };  // Which pixels of this tile already have a value, 4 KB
+
+    // Windows are sampled once per pixel: side samples scale world units apart around each peak
+    SeparableWindow& window = windows[worker];
+    double scale = grid.scale();
+    double halfWidth = grid.width() / 2.0;
+    double halfHeight = grid.height() / 2.0;
+    size_t side = static_cast<size_t>(2 * radius / scale) + 1;
+
+    // Max over the values while they are still in cache, the pixels never computed stay 0
+    double maximum = -std::numeric_limits<double>::infinity();
+    size_t computedCount = 0;
+
+    for (size_t p = 0; p < peaks.size(); ++p) {
+        double minX = peaks.x[p] - radius;
+        double minY = peaks.y[p] - radius;
+
+        size_t aFirst, aLast, bFirst, bLast;
+        windowRange(minX, scale, halfWidth, side, i0, i1, aFirst, aLast);
+        if (aFirst == aLast) continue;
+        windowRange(minY, scale, halfHeight, side, j0, j1, bFirst, bLast);
+        if (bFirst == bLast) continue;
+
+        if (separable) {
+            window.compute(peaks, minX + aFirst * scale, minY + bFirst * scale, scale, aLast - aFirst, bLast - bFirst, t);
+        }
+
+        for (size_t a = aFirst; a < aLast; ++a) {
+            double x = minX + a * scale;
+            int i = grid.pixelX(x);
+            Scalar* column = grid.column(i);
+
+            // Collect runs of consecutive uncomputed pixels along j and evaluate each run as one row
+            size_t runB = 0;
+            int runStart = 0;
+            int runLength = 0;
+            auto evaluateRun = [&]() {
+                if (separable) {
+                    window.g0Row(a - aFirst, runB - bFirst, runLength, column + runStart);
+                } else {
+                    peaks.g0Row(x, minY + runB * scale, scale, runLength, t, column + runStart);
+                }
+                for (int j = runStart; j < runStart + runLength; ++j) {
+                    maximum = std::max(maximum, static_cast<double>(column[j]));
+                }
+                computedCount += runLength;
+                runLength = 0;
+            };
+
+            for (size_t b = bFirst; b < bLast; ++b) {
+                int j = grid.pixelY(minY + b * scale);
+                bool needed = !computed[i - i0][j - j0];
+
+                if (runLength > 0 && !(needed && j == runStart + runLength)) {
+                    evaluateRun();
+                }
+                if (needed) {
+                    if (runLength == 0) {
+                        runStart = j;
+                        runB = b;
+                    }
+                    ++runLength;
+                    computed[i - i0][j - j0] = true;
+                }
+            }
+            if (runLength > 0) {
+                evaluateRun();
+            }
+        }
+    }
+
+    if (computedCount < static_cast<size_t>((i1 - i0) * (j1 - j0))) {
+        maximum = std::max(maximum, 0.0);
+    }
+    tileMax[tile] = maximum;
+}
@@ -0,0 +1,4 @@
+#include "FieldGrid.h"
+
+GridGeometry::GridGeometry(unsigned int width, unsigned int height, double scale)
+    : width_(width > 0 ? width : 1), height_(height > 0 ? height : 1), scale_(scale > 0 ? scale : 1.0) {}
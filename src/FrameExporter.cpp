@@ -0,0 +1,145 @@
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <SFML/Graphics.hpp>
+
+#include "FrameExporter.h"
+#include "Profiler.h"
+#include "Timer.h"
+
+FrameExporter::~FrameExporter() {
+    stop();
+}
+
+bool FrameExporter::start(ExportFormat format, size_t workerCount, size_t queueCapacity, unsigned int width, unsigned int height) {
+    this->format = format;
+    this->width = width;
+    this->height = height;
+    capacity = queueCapacity > 0 ? queueCapacity : 1;
+
+    // The raw stream sits next to where the PNG frames would go, out/frames itself is only made for PNG
+    const char* directory = format == ExportFormat::RAW ? "out" : "out/frames";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    if (format == ExportFormat::RAW) {
+        stream = std::fopen("out/frames.raw", "wb");
+        if (!stream) {
+            std::cerr << "Failed to open out/frames.raw" << std::endl;
+            return false;
+        }
+        RawStreamHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "GRAVRAW", 8);
+        header.version = 1;
+        header.width = width;
+        header.height = height;
+        std::fwrite(&header, sizeof(header), 1, stream);
+        workerCount = 1;
+    }
+
+    if (workerCount == 0) workerCount = 1;
+    running = true;
+    for (size_t w = 0; w < workerCount; ++w) {
+        workers.emplace_back(&FrameExporter::workerLoop, this);
+    }
+    return true;
+}
+
+void FrameExporter::push(const std::uint8_t* rgba, long long step) {
+    PROFILE_ZONE("export/push");
+    Frame frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!running) return;
+        if (inFlight >= capacity) {
+            Timer blocked;
+            slotFree.wait(lock, [this]() { return inFlight < capacity; });
+            blockedMicroseconds += blocked.elapsed();
+        }
+        ++inFlight;
+        if (!spare.empty()) {
+            frame = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    // Copy outside the lock, the renderer reuses its buffer for the next frame
+    frame.pixels.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+    frame.step = step;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(frame));
+    }
+    frameReady.notify_one();
+}
+
+void FrameExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    frameReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    if (stream) {
+        std::fclose(stream);
+        stream = nullptr;
+    }
+    std::cerr << "Exported " << exported << " frames";
+    if (failed > 0) std::cerr << " (" << failed << " failed)";
+    std::cerr << ", producer blocked " << blockedMicroseconds << " microseconds on a full queue." << std::endl;
+}
+
+void FrameExporter::workerLoop() {
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameReady.wait(lock, [this]() { return !queued.empty() || !running; });
+            if (queued.empty()) return;  // stopped and drained
+            frame = std::move(queued.front());
+            queued.pop_front();
+        }
+
+        bool ok = encode(frame);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok) ++exported; else ++failed;
+            spare.push_back(std::move(frame));
+            --inFlight;
+        }
+        slotFree.notify_one();
+    }
+}
+
+bool FrameExporter::encode(const Frame& frame) {
+    PROFILE_ZONE("export/encode");
+    if (format == ExportFormat::RAW) {
+        std::int64_t step = frame.step;
+        return std::fwrite(&step, sizeof(step), 1, stream) == 1
+            && std::fwrite(frame.pixels.data(), 1, frame.pixels.size(), stream) == frame.pixels.size();
+    }
+
+    std::ostringstream filename;
+    filename << "out/frames/" << std::setw(9) << std::setfill('0') << frame.step << ".png";
+    sf::Image image;
+    image.create(width, height, frame.pixels.data());
+    if (!image.saveToFile(filename.str())) {
+        std::cerr << "Error: Could not write frame " << filename.str() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#include <cstring>
+
+#include "FrameSnapshot.h"
+#include "Profiler.h"
+
+void FrameSnapshot::capture(const FieldGrid& grid, double maxValue, bool withField, const ParticleSystem& particles, size_t tailLength, long long step, double tk) {
+    PROFILE_ZONE("capture");
+    if (withField) {
+        field.resize(grid.size());
+        std::memcpy(field.data(), grid.data(), field.size() * sizeof(FieldScalar));
+    } else {
+        field.clear();
+    }
+    this->maxValue = maxValue;
+    this->step = step;
+    this->tk = tk;
+
+    x = particles.x;
+    y = particles.y;
+    type = particles.type;
+
+    tailStart.clear();
+    tail.clear();
+    for (size_t p = 0; p < particles.size(); ++p) {
+        tailStart.push_back(tail.size());
+        HistoryView history = particles.history.view(p).newest(tailLength);
+        tail.insert(tail.end(), history.begin(), history.end());
+    }
+    tailStart.push_back(tail.size());
+}
+
+FrameSnapshot& FrameExchange::writeSlot() {
+    return slots[writing];
+}
+
+void FrameExchange::publish() {
+    // acq_rel: the frame written so far becomes visible with the slot, and the slot handed back is free
+    writing = middle.exchange(writing | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+const FrameSnapshot* FrameExchange::acquire() {
+    if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return nullptr;
+    reading = middle.exchange(reading, std::memory_order_acq_rel) & ~FRESH;
+    return &slots[reading];
+}
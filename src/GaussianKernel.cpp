@@ -0,0 +1,251 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#include "GaussianKernel.h"
+
+namespace {
+
+const double LOG2E = 1.4426950408889634;
+const double LN2_HI = 6.93147180369123816490e-01;  // ln2 split so n * LN2_HI is exact
+const double LN2_LO = 1.90821492927058770002e-10;
+const double EXP_MIN = -708.0;  // GaussianCutoff<double>, below this 2^n leaves the normal range
+const double EXP_MAX = 709.0;
+
+// 1/k! for k = 12 down to 0, Horner order
+const double EXP_COEFFS[13] = {
+    2.08767569878680989792e-09, 2.50521083854417187751e-08, 2.75573192239858906526e-07,
+    2.75573192239858906526e-06, 2.48015873015873015873e-05, 1.98412698412698412698e-04,
+    1.38888888888888888889e-03, 8.33333333333333333333e-03, 4.16666666666666666667e-02,
+    1.66666666666666666667e-01, 5.00000000000000000000e-01, 1.0, 1.0
+};
+
+// Float version: ln2 split as in cephes expf, minimax coefficients for the degree 2..7 terms
+const float LOG2E_F = 1.44269504088896341f;
+const float LN2_HI_F = 0.693359375f;
+const float LN2_LO_F = -2.12194440e-4f;
+const float EXP_MIN_F = -87.0f;  // GaussianCutoff<float>, exp(-87) is still a normal float
+const float EXP_MAX_F = 88.0f;
+const float EXP_COEFFS_F[8] = {
+    1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f,
+    1.6666665459e-1f, 5.0000001201e-1f, 1.0f, 1.0f
+};
+
+#if defined(__AVX2__)
+inline __m256d fastExp4(__m256d x) {
+    __m256d underflow = _mm256_cmp_pd(x, _mm256_set1_pd(EXP_MIN), _CMP_LT_OQ);
+    x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(EXP_MIN)), _mm256_set1_pd(EXP_MAX));
+
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(LN2_HI)));
+    r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(LN2_LO)));
+
+    __m256d p = _mm256_set1_pd(EXP_COEFFS[0]);
+    for (int c = 1; c < 13; ++c) {
+#if defined(__FMA__)
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_COEFFS[c]));
+#else
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(EXP_COEFFS[c]));
+#endif
+    }
+
+    // 2^n straight into the exponent bits
+    __m256i exponent = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+    exponent = _mm256_slli_epi64(_mm256_add_epi64(exponent, _mm256_set1_epi64x(1023)), 52);
+    __m256d result = _mm256_mul_pd(p, _mm256_castsi256_pd(exponent));
+    return _mm256_andnot_pd(underflow, result);
+}
+
+inline __m256 fastExp8(__m256 x) {
+    __m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(EXP_MIN_F), _CMP_LT_OQ);
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_MIN_F)), _mm256_set1_ps(EXP_MAX_F));
+
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(LOG2E_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(LN2_HI_F)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(LN2_LO_F)));
+
+    __m256 p = _mm256_set1_ps(EXP_COEFFS_F[0]);
+    for (int c = 1; c < 8; ++c) {
+#if defined(__FMA__)
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_COEFFS_F[c]));
+#else
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(EXP_COEFFS_F[c]));
+#endif
+    }
+
+    __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    __m256 result = _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+    return _mm256_andnot_ps(underflow, result);
+}
+#elif defined(__SSE4_1__)
+inline __m128d fastExp2(__m128d x) {
+    __m128d underflow = _mm_cmplt_pd(x, _mm_set1_pd(EXP_MIN));
+    x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(EXP_MIN)), _mm_set1_pd(EXP_MAX));
+
+    __m128d n = _mm_round_pd(_mm_mul_pd(x, _mm_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m128d r = _mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(LN2_HI)));
+    r = _mm_sub_pd(r, _mm_mul_pd(n, _mm_set1_pd(LN2_LO)));
+
+    __m128d p = _mm_set1_pd(EXP_COEFFS[0]);
+    for (int c = 1; c < 13; ++c) {
+        p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(EXP_COEFFS[c]));
+    }
+
+    __m128i exponent = _mm_cvtepi32_epi64(_mm_cvtpd_epi32(n));
+    exponent = _mm_slli_epi64(_mm_add_epi64(exponent, _mm_set1_epi64x(1023)), 52);
+    __m128d result = _mm_mul_pd(p, _mm_castsi128_pd(exponent));
+    return _mm_andnot_pd(underflow, result);
+}
+
+inline __m128 fastExp4f(__m128 x) {
+    __m128 underflow = _mm_cmplt_ps(x, _mm_set1_ps(EXP_MIN_F));
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_MIN_F)), _mm_set1_ps(EXP_MAX_F));
+
+    __m128 n = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(LOG2E_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(LN2_HI_F)));
+    r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(LN2_LO_F)));
+
+    __m128 p = _mm_set1_ps(EXP_COEFFS_F[0]);
+    for (int c = 1; c < 8; ++c) {
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_COEFFS_F[c]));
+    }
+
+    __m128i exponent = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+    __m128 result = _mm_mul_ps(p, _mm_castsi128_ps(exponent));
+    return _mm_andnot_ps(underflow, result);
+}
+#endif
+
+} // namespace
+
+double fastExp(double x) {
+    if (x < EXP_MIN) return 0.0;
+    if (x > EXP_MAX) x = EXP_MAX;
+
+    double n = std::nearbyint(x * LOG2E);
+    double r = x - n * LN2_HI - n * LN2_LO;
+
+    double p = EXP_COEFFS[0];
+    for (int c = 1; c < 13; ++c) {
+        p = p * r + EXP_COEFFS[c];
+    }
+
+    std::int64_t bits = (static_cast<std::int64_t>(n) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+float fastExp(float x) {
+    if (x < EXP_MIN_F) return 0.0f;
+    if (x > EXP_MAX_F) x = EXP_MAX_F;
+
+    float n = std::nearbyint(x * LOG2E_F);
+    float r = x - n * LN2_HI_F - n * LN2_LO_F;
+
+    float p = EXP_COEFFS_F[0];
+    for (int c = 1; c < 8; ++c) {
+        p = p * r + EXP_COEFFS_F[c];
+    }
+
+    std::int32_t bits = (static_cast<std::int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+template <>
+void accumulateGaussianRow<double>(double A2, double invTwoW2, double dx2, double dyStart, double dyStep, size_t count, double* prefix, double* pair) {
+    size_t k = 0;
+
+#if defined(__AVX2__)
+    const __m256d a2 = _mm256_set1_pd(A2);
+    const __m256d negInv = _mm256_set1_pd(-invTwoW2);
+    const __m256d dxSquared = _mm256_set1_pd(dx2);
+    __m256d dy = _mm256_add_pd(_mm256_set1_pd(dyStart), _mm256_mul_pd(_mm256_set_pd(3.0, 2.0, 1.0, 0.0), _mm256_set1_pd(dyStep)));
+    for (; k + 4 <= count; k += 4) {
+        __m256d r2 = _mm256_add_pd(dxSquared, _mm256_mul_pd(dy, dy));
+        __m256d a = _mm256_mul_pd(a2, fastExp4(_mm256_mul_pd(r2, negInv)));
+        __m256d before = _mm256_loadu_pd(prefix + k);
+        _mm256_storeu_pd(pair + k, _mm256_add_pd(_mm256_loadu_pd(pair + k), _mm256_mul_pd(a, before)));
+        _mm256_storeu_pd(prefix + k, _mm256_add_pd(before, a));
+        dy = _mm256_add_pd(dy, _mm256_set1_pd(4.0 * dyStep));
+    }
+#elif defined(__SSE4_1__)
+    const __m128d a2 = _mm_set1_pd(A2);
+    const __m128d negInv = _mm_set1_pd(-invTwoW2);
+    const __m128d dxSquared = _mm_set1_pd(dx2);
+    __m128d dy = _mm_add_pd(_mm_set1_pd(dyStart), _mm_mul_pd(_mm_set_pd(1.0, 0.0), _mm_set1_pd(dyStep)));
+    for (; k + 2 <= count; k += 2) {
+        __m128d r2 = _mm_add_pd(dxSquared, _mm_mul_pd(dy, dy));
+        __m128d a = _mm_mul_pd(a2, fastExp2(_mm_mul_pd(r2, negInv)));
+        __m128d before = _mm_loadu_pd(prefix + k);
+        _mm_storeu_pd(pair + k, _mm_add_pd(_mm_loadu_pd(pair + k), _mm_mul_pd(a, before)));
+        _mm_storeu_pd(prefix + k, _mm_add_pd(before, a));
+        dy = _mm_add_pd(dy, _mm_set1_pd(2.0 * dyStep));
+    }
+#endif
+
+    // Tail (or the whole row without SIMD), scalar std::exp beats the polynomial here
+    for (; k < count; ++k) {
+        double dy = dyStart + static_cast<double>(k) * dyStep;
+        double exponent = (dx2 + dy * dy) * invTwoW2;
+        double a = exponent > -EXP_MIN ? 0.0 : A2 * exp(-exponent);
+        pair[k] += a * prefix[k];
+        prefix[k] += a;
+    }
+}
+
+template <>
+void accumulateGaussianRow<float>(double A2, double invTwoW2, double dx2, double dyStart, double dyStep, size_t count, float* prefix, float* pair) {
+    const float a2 = static_cast<float>(A2);
+    const float inv = static_cast<float>(invTwoW2);
+    const float dxSquared = static_cast<float>(dx2);
+    const float start = static_cast<float>(dyStart);
+    const float step = static_cast<float>(dyStep);
+    size_t k = 0;
+
+    // dy from the lane index rather than by repeated adds, float would drift along a long row
+#if defined(__AVX2__)
+    const __m256 a2v = _mm256_set1_ps(a2);
+    const __m256 negInv = _mm256_set1_ps(-inv);
+    const __m256 dxv = _mm256_set1_ps(dxSquared);
+    __m256 index = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+    for (; k + 8 <= count; k += 8) {
+        __m256 dy = _mm256_add_ps(_mm256_set1_ps(start), _mm256_mul_ps(index, _mm256_set1_ps(step)));
+        __m256 r2 = _mm256_add_ps(dxv, _mm256_mul_ps(dy, dy));
+        __m256 a = _mm256_mul_ps(a2v, fastExp8(_mm256_mul_ps(r2, negInv)));
+        __m256 before = _mm256_loadu_ps(prefix + k);
+        _mm256_storeu_ps(pair + k, _mm256_add_ps(_mm256_loadu_ps(pair + k), _mm256_mul_ps(a, before)));
+        _mm256_storeu_ps(prefix + k, _mm256_add_ps(before, a));
+        index = _mm256_add_ps(index, _mm256_set1_ps(8.0f));
+    }
+#elif defined(__SSE4_1__)
+    const __m128 a2v = _mm_set1_ps(a2);
+    const __m128 negInv = _mm_set1_ps(-inv);
+    const __m128 dxv = _mm_set1_ps(dxSquared);
+    __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    for (; k + 4 <= count; k += 4) {
+        __m128 dy = _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(index, _mm_set1_ps(step)));
+        __m128 r2 = _mm_add_ps(dxv, _mm_mul_ps(dy, dy));
+        __m128 a = _mm_mul_ps(a2v, fastExp4f(_mm_mul_ps(r2, negInv)));
+        __m128 before = _mm_loadu_ps(prefix + k);
+        _mm_storeu_ps(pair + k, _mm_add_ps(_mm_loadu_ps(pair + k), _mm_mul_ps(a, before)));
+        _mm_storeu_ps(prefix + k, _mm_add_ps(before, a));
+        index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+    }
+#endif
+
+    // Tail, cut off where the vector lanes are so every pixel of a row sees the same terms
+    for (; k < count; ++k) {
+        float dy = start + static_cast<float>(k) * step;
+        float exponent = (dxSquared + dy * dy) * inv;
+        float a = exponent > -EXP_MIN_F ? 0.0f : a2 * std::exp(-exponent);
+        pair[k] += a * prefix[k];
+        prefix[k] += a;
+    }
+}
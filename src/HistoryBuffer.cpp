@@ -0,0 +1,24 @@
+#include "HistoryBuffer.h"
+
+HistoryBuffer::HistoryBuffer(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+void HistoryBuffer::addParticle(const std::vector<Position>& initial) {
+    size_t particle = head.size();
+    slots.resize(slots.size() + capacity_);
+    head.push_back(0);
+    count.push_back(0);
+
+    size_t skip = initial.size() > capacity_ ? initial.size() - capacity_ : 0;
+    for (size_t i = skip; i < initial.size(); ++i) {
+        push(particle, initial[i].first, initial[i].second);
+    }
+}
+
+std::vector<HistoryBuffer::Position> HistoryBuffer::copy(size_t particle) const {
+    HistoryView history = view(particle);
+    std::vector<Position> result(history.size());
+    for (size_t i = 0; i < history.size(); ++i) {
+        result[history.size() - 1 - i] = history[i];
+    }
+    return result;
+}
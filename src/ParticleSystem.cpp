@@ -0,0 +1,326 @@
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "ParticleSystem.h"
+#include "GaussianKernel.h"
+#include "Quadtree.h"
+#include "Timer.h"
+#include "Profiler.h"
+
+namespace {
+
+template <typename T>
+void permute(std::vector<T>& column, const std::vector<size_t>& order) {
+    std::vector<T> reordered(column.size());
+    for (size_t p = 0; p < order.size(); ++p) {
+        reordered[p] = column[order[p]];
+    }
+    column.swap(reordered);
+}
+
+// updatePosition<Type> for every ParticleType, indexed by type
+template <size_t... Types>
+std::array<ParticleSystem::UpdateKernel, sizeof...(Types)> updateKernels(std::index_sequence<Types...>) {
+    return {{ &ParticleSystem::updatePosition<static_cast<ParticleType>(Types)>... }};
+}
+
+} // namespace
+
+ParticleSystem::ParticleSystem(size_t historyCapacity) : history(historyCapacity) {}
+
+void ParticleSystem::add(const Particle& particle) {
+    x.push_back(particle.x_offset_);
+    y.push_back(particle.y_offset_);
+    vx.push_back(particle.velocity_x_);
+    vy.push_back(particle.velocity_y_);
+    A.push_back(particle.A_);
+    W.push_back(particle.W_);
+    invTwoWSquared.push_back(1.0 / (2 * particle.W_ * particle.W_));
+    type.push_back(particle.type_);
+
+    spin.push_back(particle.spin_);
+    isLocked.push_back(particle.isLocked);
+    lockedMagnitude.push_back(particle.lockedMagnitude);
+    history.addParticle(particle.history_);
+
+    nextX.push_back(particle.x_offset_);
+    nextY.push_back(particle.y_offset_);
+    nextVX.push_back(particle.velocity_x_);
+    nextVY.push_back(particle.velocity_y_);
+    nextIsLocked.push_back(particle.isLocked);
+    nextLockedMagnitude.push_back(particle.lockedMagnitude);
+}
+
+size_t ParticleSystem::size() const {
+    return x.size();
+}
+
+bool ParticleSystem::groupByType() {
+    bool reorder = !std::is_sorted(type.begin(), type.end());
+    if (reorder) {
+        std::vector<size_t> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return type[a] < type[b]; });
+
+        permute(x, order);
+        permute(y, order);
+        permute(vx, order);
+        permute(vy, order);
+        permute(A, order);
+        permute(W, order);
+        permute(invTwoWSquared, order);
+        permute(type, order);
+        permute(spin, order);
+        permute(isLocked, order);
+        permute(lockedMagnitude, order);
+        permute(nextX, order);
+        permute(nextY, order);
+        permute(nextVX, order);
+        permute(nextVY, order);
+        permute(nextIsLocked, order);
+        permute(nextLockedMagnitude, order);
+
+        HistoryBuffer grouped(history.capacity());
+        for (size_t p : order) {
+            grouped.addParticle(history.copy(p));
+        }
+        history = std::move(grouped);
+    }
+
+    for (int bucket = 0; bucket <= PARTICLE_TYPE_COUNT; ++bucket) {
+        bucketStart[bucket] = std::lower_bound(type.begin(), type.end(), bucket) - type.begin();
+    }
+    return reorder;
+}
+
+void ParticleSystem::swapBuffers() {
+    x.swap(nextX);
+    y.swap(nextY);
+    vx.swap(nextVX);
+    vy.swap(nextVY);
+    isLocked.swap(nextIsLocked);
+    lockedMagnitude.swap(nextLockedMagnitude);
+}
+
+Particle ParticleSystem::particle(size_t i) const {
+    Particle result(A[i], W[i], x[i], y[i], type[i]);  // this constructor draws no spin from the random engine
+    result.velocity_x_ = vx[i];
+    result.velocity_y_ = vy[i];
+    result.spin_ = spin[i];
+    result.isLocked = isLocked[i];
+    result.lockedMagnitude = lockedMagnitude[i];
+    result.history_ = history.copy(i);
+    return result;
+}
+
+// Same running pair sum as Particle::g0, over the SoA arrays
+double ParticleSystem::g0(double px, double py, double t) const {
+    double pair = 0.0;
+    double prefix = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double a = valueAt(i, px, py, t);
+        pair += a * prefix;
+        prefix += a;
+    }
+    return pair;
+}
+
+template <typename Scalar>
+void ParticleSystem::g0Row(double px, double yStart, double yStep, size_t count, double t, Scalar* out) const {
+    const size_t BLOCK = 256;
+    Scalar prefix[BLOCK];
+    Scalar pair[BLOCK];
+
+    for (size_t start = 0; start < count; start += BLOCK) {
+        size_t n = std::min(BLOCK, count - start);
+        std::fill(prefix, prefix + n, Scalar(0));
+        std::fill(pair, pair + n, Scalar(0));
+
+        for (size_t i = 0; i < x.size(); ++i) {
+            double dx = px - x[i];
+            double dx2 = dx * dx;
+            if (dx2 * invTwoWSquared[i] > GaussianCutoff<Scalar>::exponent) continue;  // exp underflows to 0 for the whole row
+            accumulateGaussianRow(A[i] * A[i], invTwoWSquared[i], dx2, yStart + start * yStep - y[i], yStep, n, prefix, pair);
+        }
+
+        std::copy(pair, pair + n, out + start);
+    }
+}
+
+template void ParticleSystem::g0Row<double>(double, double, double, size_t, double, double*) const;
+template void ParticleSystem::g0Row<float>(double, double, double, size_t, double, float*) const;
+
+// grad g0 = sum_j (grad a_j * sum_{i<j} a_i + a_j * sum_{i<j} grad a_i), the same running pair sum as g0,
+// with grad a_i = -2 (p - p_i) a_i / (2 W_i^2). One pass, no grid.
+void ParticleSystem::g0Gradient(double px, double py, double t, double& gradientX, double& gradientY) const {
+    double gx = 0.0, gy = 0.0;
+    double prefix = 0.0;
+    double prefixGx = 0.0, prefixGy = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double dx = px - x[i];
+        double dy = py - y[i];
+        double exponent = (dx * dx + dy * dy) * invTwoWSquared[i];
+        if (exponent > GaussianCutoff<double>::exponent) continue;  // dropped as 0, like the row kernel does
+        double a = A[i] * A[i] * exp(-exponent);
+        double ax = -2.0 * dx * invTwoWSquared[i] * a;
+        double ay = -2.0 * dy * invTwoWSquared[i] * a;
+        gx += ax * prefix + a * prefixGx;
+        gy += ay * prefix + a * prefixGy;
+        prefix += a;
+        prefixGx += ax;
+        prefixGy += ay;
+    }
+    gradientX = gx;
+    gradientY = gy;
+}
+
+ParticleSystem::UpdateKernel ParticleSystem::updateKernel(ParticleType type) {
+    static const std::array<UpdateKernel, PARTICLE_TYPE_COUNT> KERNELS = updateKernels(std::make_index_sequence<PARTICLE_TYPE_COUNT>());
+    return KERNELS[type];
+}
+
+void ParticleSystem::updatePosition(size_t n, const QuadTree& qtree, double theta, double t, double k, const FieldGrid& grid, bool analyticGradient, double tk, Telemetry& telemetry) {
+    (this->*updateKernel(type[n]))(n, qtree, theta, t, k, grid, analyticGradient, tk, telemetry);
+}
+
+template <ParticleType Type>
+void ParticleSystem::updatePosition(size_t n, const QuadTree& qtree, double theta, double t, double k, const FieldGrid& grid, bool analyticGradient, double tk, Telemetry& telemetry) {
+    PROFILE_ZONE("update/particle");
+    constexpr ParticleTraits TRAITS = PARTICLE_TRAITS[Type];
+    // Read the previous state buffer, write the next one; other particles are only read through x/y
+    double x_offset = x[n];
+    double y_offset = y[n];
+    double velocity_x = vx[n];
+    double velocity_y = vy[n];
+    bool locked = isLocked[n] != 0;
+    double lockMagnitude = lockedMagnitude[n];
+
+    double total_force_x = 0.0;
+    double total_force_y = 0.0;
+
+    {
+        PROFILE_ZONE("update/forces");
+        // 1. Barnes-Hut walk of the shared tree: far cells add their force here, the rest come back as nearby particles ----------------------------------------------<<<<<<<<<<<<<<<<
+        thread_local std::vector<unsigned int> nearbyParticles;  // per update thread, keeps its capacity between particles and steps
+        nearbyParticles.clear();
+        qtree.accumulateForce(n, theta, t, total_force_x, total_force_y, nearbyParticles);
+
+        // 2. Compute the forces based on these nearby particles    ----------------------------------------------<<<<<<<<<<<<<<<<
+        for(unsigned int other : nearbyParticles) {
+            if(other != n) {
+                // Towards the other particle, gravity pulls that way
+                double dx = x[other] - x_offset;
+                double dy = y[other] - y_offset;
+
+                double distanceSquared = dx*dx + dy*dy;
+                double distance = sqrt(distanceSquared);
+
+                // Avoiding division by zero
+                if(distanceSquared == 0) continue;
+
+                // Calculate "masses" using the valueAt function
+                double m1 = valueAt(n, x_offset, y_offset, t);
+                double m2 = valueAt(other, x[other], y[other], t);
+
+                // Newton's gravitational force
+                double force_magnitude = G * m1 * m2 / distanceSquared;
+
+                total_force_x += force_magnitude * dx / distance;
+                total_force_y += force_magnitude * dy / distance;
+
+                telemetry.record(CHANNEL_INTERACTIONS, static_cast<std::uint32_t>(n), type[other], sqrt(velocity_x * velocity_x + velocity_y * velocity_y), tk);
+            }
+        }
+    }
+
+    double gradient_x = 0.0;
+    double gradient_y = 0.0;
+
+    if (analyticGradient) {
+        g0Gradient(x_offset, y_offset, t, gradient_x, gradient_y);
+    } else {
+        int i = grid.pixelX(x_offset);
+        int j = grid.pixelY(y_offset);
+
+        // Gradient computation using finite differences (neighbours are scale world units apart),
+        // zero once the particle has left the grid
+        double spacing = 2.0 * grid.scale();
+        if (grid.contains(i - 1, j) && grid.contains(i + 1, j)) {
+            gradient_x = (grid.column(i + 1)[j] - grid.column(i - 1)[j]) / spacing;
+        }
+
+        if (grid.contains(i, j - 1) && grid.contains(i, j + 1)) {
+            gradient_y = (grid.column(i)[j + 1] - grid.column(i)[j - 1]) / spacing;
+        }
+    }
+
+    // Update velocity based on gradient and gravity, both go through the type's locks and scale below
+    double velocityChangeX = (gradient_x + total_force_x) * t;
+    double velocityChangeY = (gradient_y + total_force_y) * t;
+
+    // Ensure velocity changes don't exceed locks
+    if(std::abs(velocityChangeX) > TRAITS.velocityLockX) {
+        velocityChangeX = (velocityChangeX > 0) ? TRAITS.velocityLockX : -TRAITS.velocityLockX;
+    }
+
+    if(std::abs(velocityChangeY) > TRAITS.velocityLockY) {
+        velocityChangeY = (velocityChangeY > 0) ? TRAITS.velocityLockY : -TRAITS.velocityLockY;
+    }
+
+    // Adjust velocity based on spin and its strength: left decreases x and increases y, right the opposite
+    double spinEffect = (spin[n] == LEFT ? -TRAITS.spinStrength : TRAITS.spinStrength) * t;
+    velocity_x += spinEffect;
+    velocity_y -= spinEffect;
+
+    velocityChangeX *= TRAITS.gradientScale;  // chunkiBoi for A3, 1 for the others
+    velocityChangeY *= TRAITS.gradientScale;
+
+    velocity_x += velocityChangeX;
+    velocity_y += velocityChangeY;
+    
+    // Adjust velocities if they surpass the lock
+    double currentMagnitude = sqrt(velocity_x * velocity_x + velocity_y * velocity_y);
+
+    if (!locked) {
+        if (std::abs(velocity_x) > TRAITS.velocityLockX || std::abs(velocity_y) > TRAITS.velocityLockY) {
+            locked = true;
+            lockMagnitude = currentMagnitude;
+
+            // Adjust velocities proportionally
+            double ratioX = velocity_x / currentMagnitude;
+            double ratioY = velocity_y / currentMagnitude;
+            
+            velocity_x = ratioX * lockMagnitude;
+            velocity_y = ratioY * lockMagnitude;
+        }
+    } else {
+        // If we are locked and either velocity is now below the lock, unlock
+        if (std::abs(velocity_x) <= TRAITS.velocityLockX && std::abs(velocity_y) <= TRAITS.velocityLockY) {
+            locked = false;
+        } else {
+            // If still locked, adjust velocities to keep the same locked magnitude
+            double ratioX = velocity_x / currentMagnitude;
+            double ratioY = velocity_y / currentMagnitude;
+
+            velocity_x = ratioX * lockMagnitude;
+            velocity_y = ratioY * lockMagnitude;
+        }
+    }
+
+    // Update position based on velocity
+    x_offset += velocity_x * t;
+    y_offset += velocity_y * t;
+
+    nextX[n] = x_offset;
+    nextY[n] = y_offset;
+    nextVX[n] = velocity_x;
+    nextVY[n] = velocity_y;
+    nextIsLocked[n] = locked;
+    nextLockedMagnitude[n] = lockMagnitude;
+
+    history.push(n, x_offset, y_offset);
+}
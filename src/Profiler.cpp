@@ -0,0 +1,109 @@
+#include "Profiler.h"
+
+#ifdef GRAV_PROFILE
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+long long Profiler::now() const {
+    return clock.elapsedNanoseconds();
+}
+
+Profiler::ThreadBuffer& Profiler::localBuffer() {
+    // Buffers are owned by the profiler, so events of a thread that already exited are still collected
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+        buffer->thread = static_cast<unsigned int>(buffers.size() - 1);
+    }
+    return *buffer;
+}
+
+void Profiler::record(const char* name, long long start, long long duration) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(Event{ name, start, duration });
+}
+
+void Profiler::endFrame() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map<std::string, double> frameTotals;
+    for (const auto& buffer : buffers) {
+        scratch.clear();
+        {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            scratch.swap(buffer->events);
+        }
+
+        for (const Event& event : scratch) {
+            frameTotals[event.name] += event.duration / 1000.0;
+            ++zones[event.name].calls;
+            if (trace.size() < MAX_TRACE_EVENTS) {
+                trace.push_back(TraceEvent{ event, buffer->thread });
+            }
+        }
+    }
+
+    if (frameTotals.empty()) return;
+    for (const auto& total : frameTotals) {
+        zones[total.first].frameTimes.push_back(total.second);
+    }
+    ++frames;
+}
+
+void Profiler::report(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    out << "Profile over " << frames << " frames (microseconds per frame, summed over threads):" << std::endl;
+    for (const auto& zone : zones) {
+        std::vector<double> times = zone.second.frameTimes;
+        if (times.empty()) continue;
+        std::sort(times.begin(), times.end());
+
+        double sum = 0.0;
+        for (double time : times) sum += time;
+        size_t p99 = static_cast<size_t>(std::ceil(0.99 * times.size())) - 1;
+
+        out << "  " << std::left << std::setw(24) << zone.first << std::right << std::fixed << std::setprecision(1)
+            << " frames=" << times.size()
+            << " calls/frame=" << static_cast<double>(zone.second.calls) / times.size()
+            << " min=" << times.front()
+            << " mean=" << sum / times.size()
+            << " p99=" << times[p99] << std::endl;
+        out.unsetf(std::ios::floatfield);
+    }
+}
+
+bool Profiler::writeChromeTrace(const std::string& filename) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::FILE* file = std::fopen(filename.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "Failed to open profile trace " << filename << std::endl;
+        return false;
+    }
+
+    // Timestamps are microseconds in the trace format, fractional values keep the nanoseconds
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const TraceEvent& entry = trace[i];
+        std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                     entry.event.name, entry.thread, entry.event.start / 1000.0, entry.event.duration / 1000.0,
+                     i + 1 < trace.size() ? "," : "");
+    }
+    std::fprintf(file, "]}\n");
+    return std::fclose(file) == 0;
+}
+
+#endif // GRAV_PROFILE
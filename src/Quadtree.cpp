@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "Quadtree.h"
 #include "Particle.h"
 #include "HugoStable.h"
@@ -6,10 +8,14 @@
 Boundary::Boundary(double x, double y, double w, double h) : x(x), y(y), width(w), height(h) {}
 
 bool Boundary::contains(const Particle& particle) const {
-    return (particle.getX() >= x - width &&
-            particle.getX() <= x + width &&
-            particle.getY() >= y - height &&
-            particle.getY() <= y + height);
+    return contains(particle.getX(), particle.getY());
+}
+
+bool Boundary::contains(double px, double py) const {
+    return (px >= x - width &&
+            px <= x + width &&
+            py >= y - height &&
+            py <= y + height);
 }
 
 bool Boundary::intersects(const Boundary& other) const {
@@ -19,83 +25,185 @@ bool Boundary::intersects(const Boundary& other) const {
              other.y + other.height < y - height);
 }
 
-// Implementations for QuadTreeNode
-QuadTreeNode::QuadTreeNode(Boundary boundary, size_t capacity) : boundary(boundary), capacity(capacity) {}
-
-QuadTreeNode::~QuadTreeNode() {
-    delete northwest;
-    delete northeast;
-    delete southwest;
-    delete southeast;
+// Implementations for QuadTree
+QuadTree::QuadTree(Boundary boundary) : rootBoundary(boundary) {
+    clear();
 }
 
-bool QuadTreeNode::insert(Particle* particle) {
-    if (!boundary.contains(*particle)) return false;
-    
-    if (particles.size() < capacity) {
-        particles.push_back(particle);
-        return true;
+void QuadTree::build(const ParticleSystem& particles) {
+    clear();
+    this->particles = &particles;
+    for (unsigned int i = 0; i < particles.size(); ++i) {
+        insert(i);
     }
-    
-    if (!northwest) {
-        subdivide();
-    }
-
-    if (northwest->insert(particle)) return true;
-    if (northeast->insert(particle)) return true;
-    if (southwest->insert(particle)) return true;
-    if (southeast->insert(particle)) return true;
+}
 
-    return false;
+int QuadTree::allocate(const Boundary& boundary) {
+    if (used == nodes.size()) {
+        nodes.emplace_back(boundary);
+    } else {
+        nodes[used] = QuadTreeNode(boundary);
+    }
+    return static_cast<int>(used++);
 }
 
-void QuadTreeNode::subdivide() {
+void QuadTree::subdivide(int node) {
+    Boundary boundary = nodes[node].boundary;
     double x = boundary.x;
     double y = boundary.y;
     double halfW = boundary.width / 2;
     double halfH = boundary.height / 2;
 
-    northwest = new QuadTreeNode(Boundary(x - halfW, y - halfH, halfW, halfH), capacity);
-    northeast = new QuadTreeNode(Boundary(x + halfW, y - halfH, halfW, halfH), capacity);
-    southwest = new QuadTreeNode(Boundary(x - halfW, y + halfH, halfW, halfH), capacity);
-    southeast = new QuadTreeNode(Boundary(x + halfW, y + halfH, halfW, halfH), capacity);
+    int first = allocate(Boundary(x - halfW, y - halfH, halfW, halfH));  // northwest
+    allocate(Boundary(x + halfW, y - halfH, halfW, halfH));              // northeast
+    allocate(Boundary(x - halfW, y + halfH, halfW, halfH));              // southwest
+    allocate(Boundary(x + halfW, y + halfH, halfW, halfH));              // southeast
+    nodes[node].firstChild = first;
 }
 
-void QuadTreeNode::query(const Boundary& range, std::vector<Particle*>& found) const {
-    if (!boundary.intersects(range)) return;
+bool QuadTree::insert(unsigned int index) {
+    double px = particles->x[index];
+    double py = particles->y[index];
+    if (!rootBoundary.contains(px, py)) return false;
+
+    int node = 0;
+    int depth = 0;
+    while (true) {
+        if (nodes[node].count < QuadTreeNode::CAPACITY) {
+            nodes[node].items[nodes[node].count++] = index;
+            return true;
+        }
 
-    for (Particle* particle : particles) {
-        if (range.contains(*particle)) {
-            found.push_back(particle);
+        if (depth >= MAX_DEPTH) {
+            // Cells this small only fill up with (nearly) coincident particles, chain instead of splitting
+            if (nodes[node].next < 0) {
+                int overflow = allocate(nodes[node].boundary);
+                nodes[node].next = overflow;
+            }
+            node = nodes[node].next;
+            continue;
         }
-    }
 
-    if (!northwest) return;
+        if (nodes[node].firstChild < 0) {
+            subdivide(node);
+        }
 
-    northwest->query(range, found);
-    northeast->query(range, found);
-    southwest->query(range, found);
-    southeast->query(range, found);
+        // Same tie-breaking as checking northwest, northeast, southwest, southeast in order
+        const Boundary& boundary = nodes[node].boundary;
+        int quadrant = (px > boundary.x ? 1 : 0) + (py > boundary.y ? 2 : 0);
+        node = nodes[node].firstChild + quadrant;
+        ++depth;
+    }
 }
 
-// Implementations for QuadTree
-QuadTree::QuadTree(Boundary boundary, size_t capacity) {
-    root = new QuadTreeNode(boundary, capacity);
+void QuadTree::clear() {
+    used = 0;
+    allocate(rootBoundary);
 }
 
-QuadTree::~QuadTree() {
-    delete root;
-}
+void QuadTree::query(const Boundary& range, std::vector<unsigned int>& found) const {
+    int stack[4 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
 
-void QuadTree::insert(Particle* particle) {
-    root->insert(particle);
+    while (top > 0) {
+        const QuadTreeNode& node = nodes[stack[--top]];
+        if (!range.intersects(node.boundary)) continue;
+
+        for (unsigned int i = 0; i < node.count; ++i) {
+            unsigned int index = node.items[i];
+            if (range.contains(particles->x[index], particles->y[index])) {
+                found.push_back(index);
+            }
+        }
+
+        if (node.next >= 0) stack[top++] = node.next;
+        if (node.firstChild < 0) continue;
+        for (int c = 3; c >= 0; --c) {
+            stack[top++] = node.firstChild + c;
+        }
+    }
 }
 
-void QuadTree::clear() {
-    delete root;
-    root = new QuadTreeNode(root->boundary, root->capacity);
+void QuadTree::computeMassDistribution(double t) {
+    // Children and overflow nodes are always allocated after their parent,
+    // so walking the arena backwards visits every node after its subtree
+    for (size_t n = used; n-- > 0;) {
+        QuadTreeNode& node = nodes[n];
+        double mass = 0.0;
+        double weightedX = 0.0;
+        double weightedY = 0.0;
+
+        for (unsigned int i = 0; i < node.count; ++i) {
+            unsigned int index = node.items[i];
+            double px = particles->x[index];
+            double py = particles->y[index];
+            double m = particles->valueAt(index, px, py, t);
+            mass += m;
+            weightedX += m * px;
+            weightedY += m * py;
+        }
+
+        if (node.firstChild >= 0) {
+            for (int c = 0; c < 4; ++c) {
+                const QuadTreeNode& child = nodes[node.firstChild + c];
+                mass += child.mass;
+                weightedX += child.mass * child.centerX;
+                weightedY += child.mass * child.centerY;
+            }
+        }
+
+        if (node.next >= 0) {
+            const QuadTreeNode& overflow = nodes[node.next];
+            mass += overflow.mass;
+            weightedX += overflow.mass * overflow.centerX;
+            weightedY += overflow.mass * overflow.centerY;
+        }
+
+        node.mass = mass;
+        if (mass > 0.0) {
+            node.centerX = weightedX / mass;
+            node.centerY = weightedY / mass;
+        } else {
+            node.centerX = node.boundary.x;
+            node.centerY = node.boundary.y;
+        }
+    }
 }
 
-void QuadTree::query(const Boundary& range, std::vector<Particle*>& found) const {
-    root->query(range, found);
+void QuadTree::accumulateForce(unsigned int target, double theta, double t, double& force_x, double& force_y, std::vector<unsigned int>& direct) const {
+    double targetX = particles->x[target];
+    double targetY = particles->y[target];
+    double m1 = particles->valueAt(target, targetX, targetY, t);
+
+    int stack[4 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const QuadTreeNode& node = nodes[stack[--top]];
+        if (node.mass == 0.0) continue;
+
+        double dx = node.centerX - targetX;  // towards the cell's centre of mass
+        double dy = node.centerY - targetY;
+        double distanceSquared = dx*dx + dy*dy;
+        double size = 2.0 * node.boundary.width;  // boundary stores half extents
+
+        // Far enough away: treat the whole cell as one body at its centre of mass
+        if (!node.boundary.contains(targetX, targetY) && distanceSquared > 0 && size * size < theta * theta * distanceSquared) {
+            double distance = sqrt(distanceSquared);
+            double force_magnitude = G * m1 * node.mass / distanceSquared;
+            force_x += force_magnitude * dx / distance;
+            force_y += force_magnitude * dy / distance;
+            continue;
+        }
+
+        direct.insert(direct.end(), node.items, node.items + node.count);
+
+        if (node.next >= 0) stack[top++] = node.next;
+        if (node.firstChild < 0) continue;
+        for (int c = 3; c >= 0; --c) {
+            stack[top++] = node.firstChild + c;
+        }
+    }
 }
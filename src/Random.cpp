@@ -0,0 +1,21 @@
+#include "Random.h"
+
+std::mt19937& randomEngine() {
+    static std::mt19937 gen;
+    return gen;
+}
+
+unsigned int seedRandom(unsigned int seed) {
+    if (seed == 0) {
+        std::random_device rd;
+        seed = rd();
+        if (seed == 0) seed = 1;
+    }
+    randomEngine().seed(seed);
+    return seed;
+}
+
+double getRandomDouble(double min, double max) {
+    std::uniform_real_distribution<> dis(min, max);
+    return dis(randomEngine());
+}
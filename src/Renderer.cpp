@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "Renderer.h"
+#include "ParticleTraits.h"
+#include "Profiler.h"
+
+namespace {
+
+const int BLOCK = 32;  // field pass works in square blocks, result is read by rows and the buffer written by columns
+
+sf::Color typeColor(ParticleType type) {
+    const ParticleTraits& traits = traitsOf(type);
+    return sf::Color(traits.red, traits.green, traits.blue);
+}
+
+} // namespace
+
+void Renderer::DirtyRect::add(int x, int y) {
+    left = std::min(left, x);
+    top = std::min(top, y);
+    right = std::max(right, x + 1);
+    bottom = std::max(bottom, y + 1);
+}
+
+void Renderer::DirtyRect::add(const DirtyRect& other) {
+    if (other.empty()) return;
+    left = std::min(left, other.left);
+    top = std::min(top, other.top);
+    right = std::max(right, other.right);
+    bottom = std::max(bottom, other.bottom);
+}
+
+void Renderer::DirtyRect::setFull(int width, int height) {
+    left = 0;
+    top = 0;
+    right = width;
+    bottom = height;
+}
+
+Renderer::Renderer(const GridGeometry& grid)
+    : width_(grid.width()), height_(grid.height()), scale(grid.scale()), buffer(static_cast<size_t>(grid.width()) * grid.height() * 4, 0) {
+    // Opaque black, what sf::Image::create used to start every frame with
+    for (size_t p = 3; p < buffer.size(); p += 4) {
+        buffer[p] = 255;
+    }
+    dirty.setFull(width_, height_);
+}
+
+bool Renderer::isFull(const DirtyRect& rect) const {
+    return rect.left == 0 && rect.top == 0 && rect.right == static_cast<int>(width_) && rect.bottom == static_cast<int>(height_);
+}
+
+bool Renderer::draw(const FrameSnapshot& frame) {
+    PROFILE_ZONE("render");
+    double max_value = frame.maxValue;
+    if (!frame.field.empty() && max_value == 0.0) {
+        return false;  // nothing to normalize by; a frame without a field still draws its particles
+    }
+
+    if (!frame.field.empty()) {
+        drawField(frame.field.data(), max_value);
+        fieldDrawn = true;
+        dirty.setFull(width_, height_);
+    } else if (fieldDrawn) {
+        DirtyRect full;
+        full.setFull(width_, height_);
+        clear(full);
+        fieldDrawn = false;
+        dirty.setFull(width_, height_);
+    } else {
+        // Only the last frame's tails and dots have to go
+        clear(drawn);
+        dirty.add(drawn);
+    }
+    drawn = DirtyRect();
+
+    for (size_t p = 0; p < frame.x.size(); ++p) {
+        // Newest first, the snapshot only holds the TAIL_CUTOFF entries that are drawn
+        const std::pair<double, double>* history = &frame.tail[frame.tailStart[p]];
+        size_t history_size = frame.tailStart[p + 1] - frame.tailStart[p];
+        sf::Color faded_color = typeColor(frame.type[p]);
+
+        for (size_t i = 0; i < history_size; i++) {
+            const auto& pos = history[i];
+
+            // Calculate fade factor (from 0.2 at the start to 1.0 at the most recent position)
+            double fade_factor = 0.2 + (i / static_cast<double>(history_size)) * 0.8;
+
+            // Calculate faded alpha
+            sf::Uint8 faded_alpha = static_cast<sf::Uint8>(255 * fade_factor);
+
+            faded_color.a = faded_alpha;  // Adjusting only the alpha for transparency
+
+            setPixel(pos.first, pos.second, faded_color);
+        }
+    }
+
+    // Dots on top of the tails, coloured by peak type
+    for (size_t p = 0; p < frame.x.size(); ++p) {
+        setPixel(frame.x[p], frame.y[p], typeColor(frame.type[p]));
+    }
+
+    dirty.add(drawn);
+    return true;
+}
+
+void Renderer::drawField(const FieldScalar* field, double max_value) {
+    PROFILE_ZONE("render/normalize");
+    // Normalize the grid to range 0 - 255 and write the grayscale straight into the buffer,
+    // field[i * height + j] is pixel (x = i, y = j)
+    const double normalize = 255.0 / max_value;
+    const int width = static_cast<int>(width_);
+    const int height = static_cast<int>(height_);
+    for (int i0 = 0; i0 < width; i0 += BLOCK) {
+        int i1 = std::min(i0 + BLOCK, width);
+        for (int j0 = 0; j0 < height; j0 += BLOCK) {
+            int j1 = std::min(j0 + BLOCK, height);
+            for (int i = i0; i < i1; ++i) {
+                const FieldScalar* column = field + static_cast<size_t>(i) * height_;
+                sf::Uint8* pixel = &buffer[(static_cast<size_t>(j0) * width_ + i) * 4];
+                for (int j = j0; j < j1; ++j) {
+                    std::uint32_t value = static_cast<unsigned char>(column[j] * normalize) / 4;
+                    std::uint32_t rgba = value | value << 8 | value << 16 | 0xFF000000u;  // r, g, b, a in memory order on little endian
+                    std::memcpy(pixel, &rgba, 4);
+                    pixel += static_cast<size_t>(width_) * 4;
+                }
+            }
+        }
+    }
+}
+
+void Renderer::clear(const DirtyRect& rect) {
+    for (int y = rect.top; y < rect.bottom; ++y) {
+        sf::Uint8* pixel = &buffer[(static_cast<size_t>(y) * width_ + rect.left) * 4];
+        for (int x = rect.left; x < rect.right; ++x) {
+            pixel[0] = 0;
+            pixel[1] = 0;
+            pixel[2] = 0;
+            pixel[3] = 255;
+            pixel += 4;
+        }
+    }
+}
+
+void Renderer::setPixel(double worldX, double worldY, sf::Color color) {
+    // Same mapping as FieldGrid::pixelX/pixelY
+    int x = static_cast<int>(worldX / scale + width_ / 2.0);
+    int y = static_cast<int>(worldY / scale + height_ / 2.0);
+
+    // Particles that left the grid keep simulating but are not drawn
+    if (x < 0 || x >= static_cast<int>(width_) || y < 0 || y >= static_cast<int>(height_)) return;
+
+    sf::Uint8* pixel = &buffer[(static_cast<size_t>(y) * width_ + x) * 4];
+    pixel[0] = color.r;
+    pixel[1] = color.g;
+    pixel[2] = color.b;
+    pixel[3] = color.a;
+    drawn.add(x, y);
+}
+
+void Renderer::present(sf::RenderWindow& window) {
+    PROFILE_ZONE("present");
+    if (!textureCreated) {
+        if (!texture.create(width_, height_)) {
+            std::cerr << "Error: Could not create texture." << std::endl;
+            return;
+        }
+        sprite.setTexture(texture);
+        textureCreated = true;
+        dirty.setFull(width_, height_);
+    }
+
+    if (isFull(dirty)) {
+        texture.update(buffer.data());
+    } else if (!dirty.empty()) {
+        // Pack the rectangle's rows, update() wants a contiguous sub-image
+        size_t width = static_cast<size_t>(dirty.right - dirty.left);
+        size_t height = static_cast<size_t>(dirty.bottom - dirty.top);
+        staging.resize(width * height * 4);
+        for (size_t row = 0; row < height; ++row) {
+            const sf::Uint8* source = &buffer[((dirty.top + row) * width_ + dirty.left) * 4];
+            std::memcpy(&staging[row * width * 4], source, width * 4);
+        }
+        texture.update(staging.data(), static_cast<unsigned int>(width), static_cast<unsigned int>(height),
+                       static_cast<unsigned int>(dirty.left), static_cast<unsigned int>(dirty.top));
+    }
+    dirty = DirtyRect();
+
+    // Draw the sprite to the window
+    window.clear();
+    window.draw(sprite);
+    window.display();
+}
+
+const sf::Uint8* Renderer::pixels() const {
+    return buffer.data();
+}
@@ -0,0 +1,56 @@
+#include <cmath>
+#include <algorithm>
+
+#include "SeparableField.h"
+
+void SeparableWindow::compute(const ParticleSystem& particles, double xStart, double yStart, double step, size_t width, size_t height, double t) {
+    this->width = width;
+    this->height = height;
+    particleCount = particles.size();
+    factorX.resize(particleCount * width);
+    factorY.resize(particleCount * height);
+
+    for (size_t p = 0; p < particleCount; ++p) {
+        double A2 = particles.A[p] * particles.A[p];
+        double inv = particles.invTwoWSquared[p];
+        double* fx = &factorX[p * width];
+        double* fy = &factorY[p * height];
+        for (size_t a = 0; a < width; ++a) {
+            double dx = xStart + a * step - particles.x[p];
+            fx[a] = A2 * exp(-dx * dx * inv);
+        }
+        for (size_t b = 0; b < height; ++b) {
+            double dy = yStart + b * step - particles.y[p];
+            fy[b] = exp(-dy * dy * inv);
+        }
+    }
+}
+
+template <typename Scalar>
+void SeparableWindow::g0Row(size_t a, size_t bStart, size_t count, Scalar* out) const {
+    const size_t BLOCK = 256;
+    Scalar prefix[BLOCK];
+    Scalar pair[BLOCK];
+
+    for (size_t start = 0; start < count; start += BLOCK) {
+        size_t n = std::min(BLOCK, count - start);
+        std::fill(prefix, prefix + n, Scalar(0));
+        std::fill(pair, pair + n, Scalar(0));
+
+        for (size_t p = 0; p < particleCount; ++p) {
+            double fx = factorX[p * width + a];
+            if (fx == 0.0) continue;  // whole column underflowed for this particle
+            const double* fy = &factorY[p * height + bStart + start];
+            for (size_t k = 0; k < n; ++k) {
+                Scalar value = static_cast<Scalar>(fx * fy[k]);
+                pair[k] += value * prefix[k];
+                prefix[k] += value;
+            }
+        }
+
+        std::copy(pair, pair + n, out + start);
+    }
+}
+
+template void SeparableWindow::g0Row<double>(size_t, size_t, size_t, double*) const;
+template void SeparableWindow::g0Row<float>(size_t, size_t, size_t, float*) const;
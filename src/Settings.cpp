@@ -0,0 +1,115 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "Settings.h"
+#include "ParticleTraits.h"
+
+namespace {
+
+template <size_t... Types>
+constexpr PerType fromTraits(double ParticleTraits::*field, std::index_sequence<Types...>) {
+    return {{ PARTICLE_TRAITS[Types].*field... }};
+}
+
+} // namespace
+
+// Assume these constants are defined appropriately
+PerType TYPE_COUNT = fromTraits(&ParticleTraits::count, std::make_index_sequence<PARTICLE_TYPE_COUNT>());
+PerType TYPE_MASS = fromTraits(&ParticleTraits::mass, std::make_index_sequence<PARTICLE_TYPE_COUNT>());
+PerType TYPE_WIDTH = fromTraits(&ParticleTraits::width, std::make_index_sequence<PARTICLE_TYPE_COUNT>());
+double TAIL_CUTOFF = 5;
+double RENDER_GRAVITY_RADIUS = 5;
+double GRID_WIDTH = 1000; // field grid and window size in pixels
+double GRID_HEIGHT = 1000;
+double GRID_SCALE = 1; // world units per grid pixel
+double SHOW_GRAV = 1;
+double THETA = 0.5; // Barnes-Hut opening angle, 0 = exact all-pairs forces
+double SEPARABLE_FIELD = 0; // 1 = build each render window from per-particle row/column factor tables
+double FIELD_TOLERANCE = 0; // pixels a particle may drift before the field tiles it reaches are regenerated, 0 = exact
+double ANALYTIC_GRADIENT = 0; // 1 = forces use the closed-form gradient of g0, the field is only generated for frames
+double THREADS = 0; // worker threads for the field, 0 = all hardware threads
+double HEADLESS = 0; // 1 = no window, run until STEPS or SIM_TIME is reached
+double STEPS = 0; // stop once the step counter (kept across checkpoint resumes) reaches this, 0 = no limit
+double SIM_TIME = 0; // stop once tk reaches this, 0 = no limit
+double FRAME_EVERY = 0; // headless only: render and export a frame every Nth step, 0 = never render
+double TELEMETRY_INTERACTIONS = 1; // binary telemetry channels written to telemetry.bin, 1 = on
+double TELEMETRY_INTERACTIONS_SAMPLE = 1; // keep every Nth record
+double TELEMETRY_STEPS = 1;
+double TELEMETRY_STEPS_SAMPLE = 1;
+double SUBSTEPS = 1; // window only: physics steps per rendered frame
+double FRAME_BUDGET_MS = 0; // window only: hand a frame to the renderer every this many ms instead, 0 = use SUBSTEPS
+double CHECKPOINT_EVERY = 0; // write checkpoint.bin every this many steps on a background thread, 0 = never
+double EXPORT_EVERY = 0; // window only: also export every Nth presented frame, 0 = never
+double EXPORT_FORMAT = 0; // 0 = out/frames/<step>.png, 1 = one raw RGBA stream in out/frames.raw
+double EXPORT_THREADS = 2; // frame encoder threads, raw always uses one
+double SEED = 0; // seeds every random draw, 0 = new seed each run (printed at startup)
+double TIME_SCALE = 0.9;
+double k = 0.01; // 0.01 is an example value for k, adjust as needed
+
+std::array<std::string, 3> typeSettingKeys(ParticleType type) {
+    std::string n = std::to_string(type + 1);
+    return {{ "TYPE" + n + "_COUNT", "MASS" + n, "W" + n }};
+}
+
+double* typeSetting(const std::string& key) {
+    PerType* values[3] = { &TYPE_COUNT, &TYPE_MASS, &TYPE_WIDTH };  // in typeSettingKeys order
+    for (int type = 0; type < PARTICLE_TYPE_COUNT; ++type) {
+        std::array<std::string, 3> keys = typeSettingKeys(static_cast<ParticleType>(type));
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (key == keys[i]) return &(*values[i])[type];
+        }
+    }
+    return nullptr;
+}
+
+bool readSettingsFromFile(const std::string& filename,
+                          double& TIME_SCALE, double& k) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open settings file." << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        double value;
+        if (std::getline(iss, key, '=') && iss >> value) {
+            double* perType = typeSetting(key);
+            if (perType != nullptr) *perType = value;
+            else if (key == "TIME_SCALE") TIME_SCALE = value;
+            else if (key == "k") k = value;
+            else if (key == "TAIL_CUTOFF") TAIL_CUTOFF = value;
+            else if (key == "RENDER_GRAVITY_RADIUS") RENDER_GRAVITY_RADIUS = value;
+            else if (key == "GRID_WIDTH") GRID_WIDTH = value;
+            else if (key == "GRID_HEIGHT") GRID_HEIGHT = value;
+            else if (key == "GRID_SCALE") GRID_SCALE = value;
+            else if (key == "SHOW_GRAV") SHOW_GRAV = value;
+            else if (key == "THETA") THETA = value;
+            else if (key == "SEPARABLE_FIELD") SEPARABLE_FIELD = value;
+            else if (key == "FIELD_TOLERANCE") FIELD_TOLERANCE = value;
+            else if (key == "ANALYTIC_GRADIENT") ANALYTIC_GRADIENT = value;
+            else if (key == "THREADS") THREADS = value;
+            else if (key == "HEADLESS") HEADLESS = value;
+            else if (key == "STEPS") STEPS = value;
+            else if (key == "SIM_TIME") SIM_TIME = value;
+            else if (key == "FRAME_EVERY") FRAME_EVERY = value;
+            else if (key == "TELEMETRY_INTERACTIONS") TELEMETRY_INTERACTIONS = value;
+            else if (key == "TELEMETRY_INTERACTIONS_SAMPLE") TELEMETRY_INTERACTIONS_SAMPLE = value;
+            else if (key == "TELEMETRY_STEPS") TELEMETRY_STEPS = value;
+            else if (key == "TELEMETRY_STEPS_SAMPLE") TELEMETRY_STEPS_SAMPLE = value;
+            else if (key == "SEED") SEED = value;
+            else if (key == "EXPORT_EVERY") EXPORT_EVERY = value;
+            else if (key == "EXPORT_FORMAT") EXPORT_FORMAT = value;
+            else if (key == "EXPORT_THREADS") EXPORT_THREADS = value;
+            else if (key == "CHECKPOINT_EVERY") CHECKPOINT_EVERY = value;
+            else if (key == "SUBSTEPS") SUBSTEPS = value;
+            else if (key == "FRAME_BUDGET_MS") FRAME_BUDGET_MS = value;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+
+#include "Simulation.h"
+#include "Settings.h"
+#include "ParticleTraits.h"
+#include "Profiler.h"
+#include "Random.h"
+
+std::vector<Particle> randomizeParticles(int count, double A, double W, 
+                                         double x_min, double x_max, 
+                                         double y_min, double y_max, 
+                                         double vx_min, double vx_max, 
+                                         double vy_min, double vy_max,
+                                         ParticleType particleType) {
+    std::vector<Particle> particles;
+    for (int i = 0; i < count; i++) {
+        double x_offset = getRandomDouble(x_min, x_max);
+        double y_offset = getRandomDouble(y_min, y_max);
+        double velocity_x = getRandomDouble(vx_min, vx_max);
+        double velocity_y = getRandomDouble(vy_min, vy_max);
+        particles.push_back(Particle(A, W, x_offset, y_offset, velocity_x, velocity_y, particleType));
+    }
+    return particles;
+}
+
+void spawnParticles(ParticleSystem& particles) {
+    // In ParticleType order, so the particles come out grouped by type
+    for (int type = 0; type < PARTICLE_TYPE_COUNT; ++type) {
+        const ParticleTraits& traits = PARTICLE_TRAITS[type];
+        std::vector<Particle> spawned = randomizeParticles(TYPE_COUNT[type], TYPE_MASS[type], TYPE_WIDTH[type],
+                                                           traits.spawnMin, traits.spawnMax, traits.spawnMin, traits.spawnMax,
+                                                           -traits.spawnSpeed, traits.spawnSpeed, -traits.spawnSpeed, traits.spawnSpeed,
+                                                           static_cast<ParticleType>(type));
+        for (const Particle& particle : spawned) {
+            particles.add(particle);
+        }
+    }
+}
+
+void StepClock::beginStep() {
+    if (t >= 0.3 && !oscillating) {
+        oscillating = true;
+        increasing = false;
+    }
+
+    if(oscillating) {
+        if (t <= 0.29) {
+            increasing = true;
+        } else if (t >= 0.3) {
+            increasing = false;
+        }
+    }
+
+    tk += TIME_SCALE;
+}
+
+void StepClock::endStep() {
+    if(increasing) {
+        t += TIME_SCALE;
+    } else {
+        t -= TIME_SCALE;
+    }
+}
+
+void generateData(double t, FieldGrid& grid, ParticleSystem& peaks, QuadTree& qtree, FieldGenerator& field, ThreadPool& pool, Telemetry& telemetry, double tk, bool withField) {
+    bool analyticGradient = ANALYTIC_GRADIENT == 1;
+    if (peaks.groupByType()) {
+        field.invalidate();  // its anchors are per particle index
+    }
+    if (withField || !analyticGradient) {
+        PROFILE_ZONE("field");
+        field.generate(grid, peaks, RENDER_GRAVITY_RADIUS, SEPARABLE_FIELD == 1, t, FIELD_TOLERANCE, pool);
+    }
+
+    {
+        PROFILE_ZONE("quadtree");
+        // Rebuild the shared QuadTree in its arena, read-only for every particle update
+        qtree.build(peaks);
+        qtree.computeMassDistribution(t);
+    }
+
+    PROFILE_ZONE("update");
+    // Update peak positions: every particle reads the previous state and writes its own slot of the next one,
+    // one bucket at a time so each runs its type's kernel
+    for (int bucket = 0; bucket < PARTICLE_TYPE_COUNT; ++bucket) {
+        ParticleType type = static_cast<ParticleType>(bucket);
+        ParticleSystem::UpdateKernel kernel = ParticleSystem::updateKernel(type);
+        size_t begin = peaks.bucketBegin(type);
+        pool.parallelFor(peaks.bucketEnd(type) - begin, [&](size_t p, size_t /*worker*/) {
+            (peaks.*kernel)(begin + p, qtree, THETA, t, k, grid, analyticGradient, tk, telemetry);
+        });
+    }
+    peaks.swapBuffers();
+}
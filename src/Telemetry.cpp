@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "Telemetry.h"
+
+Telemetry::Telemetry() : cells(new Cell[CAPACITY]) {
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    for (auto& counter : sampleCounter) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+Telemetry::~Telemetry() {
+    stop();
+}
+
+void Telemetry::enable(TelemetryChannel channel, std::uint32_t sampleEvery) {
+    channelEnabled[channel] = true;
+    this->sampleEvery[channel] = sampleEvery > 0 ? sampleEvery : 1;
+}
+
+bool Telemetry::start(const std::string& filename) {
+    bool any = false;
+    for (bool channel : channelEnabled) any = any || channel;
+    if (!any) return true;
+
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open telemetry file " << filename << std::endl;
+        return false;
+    }
+
+    TelemetryFileHeader header;
+    std::memcpy(header.magic, "GRAVTLM", 8);
+    header.version = TELEMETRY_VERSION;
+    header.recordSize = sizeof(TelemetryRecord);
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    running.store(true);
+    writer = std::thread(&Telemetry::writerLoop, this);
+    return true;
+}
+
+void Telemetry::stop() {
+    if (!running.exchange(false)) return;
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+
+    if (droppedCount.load() > 0) {
+        std::cerr << "Telemetry dropped " << droppedCount.load() << " records (ring buffer full)." << std::endl;
+    }
+}
+
+void Telemetry::record(TelemetryChannel channel, std::uint32_t particle, std::int32_t tag, double value, double tk) {
+    if (!enabled(channel)) return;
+    if (sampleEvery[channel] > 1 && sampleCounter[channel].fetch_add(1, std::memory_order_relaxed) % sampleEvery[channel] != 0) return;
+
+    TelemetryRecord record;
+    record.tk = tk;
+    record.value = value;
+    record.channel = channel;
+    record.particle = particle;
+    record.tag = tag;
+    record.reserved = 0;
+    if (!tryPush(record)) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t Telemetry::dropped() const {
+    return droppedCount.load();
+}
+
+// Bounded MPSC ring with per-cell sequence numbers (Vyukov): a producer claims a slot with one CAS,
+// the sequence tells the writer when the slot is filled and the producers when it is free again.
+bool Telemetry::tryPush(const TelemetryRecord& record) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[pos & (CAPACITY - 1)];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.record = record;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Telemetry::tryPop(TelemetryRecord& record) {
+    Cell& cell = cells[dequeuePos & (CAPACITY - 1)];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeuePos + 1) return false;  // empty (or the producer is still writing it)
+
+    record = cell.record;
+    cell.sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+void Telemetry::writerLoop() {
+    std::vector<TelemetryRecord> batch;
+    batch.reserve(4096);
+
+    while (true) {
+        bool stopping = !running.load(std::memory_order_acquire);
+
+        TelemetryRecord record;
+        while (batch.size() < batch.capacity() && tryPop(record)) {
+            batch.push_back(record);
+        }
+
+        if (!batch.empty()) {
+            std::fwrite(batch.data(), sizeof(TelemetryRecord), batch.size(), file);
+            batch.clear();
+        } else if (stopping) {
+            return;  // stop() is only called after the producers are done, so empty means drained
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    workerCount = threadCount > 0 ? threadCount : 1;
+    slices.reset(new Slice[workerCount]);
+
+    // Worker 0 is whoever calls parallelFor
+    for (size_t worker = 1; worker < workerCount; ++worker) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workerCount;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& task) {
+    if (count == 0) return;
+
+    if (threads.empty()) {
+        for (size_t index = 0; index < count; ++index) {
+            task(index, 0);
+        }
+        return;
+    }
+
+    // All workers checked in after the previous call, nobody is touching the slices now
+    for (size_t worker = 0; worker < workerCount; ++worker) {
+        slices[worker].next.store(worker * count / workerCount, std::memory_order_relaxed);
+        slices[worker].end.store((worker + 1) * count / workerCount, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        finished = 0;
+        ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return finished == threads.size(); });
+    this->task = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        drain(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++finished == threads.size()) {
+                done.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::drain(size_t worker) {
+    // Own slice first, then sweep the others; fetch_add hands every index out exactly once
+    for (size_t offset = 0; offset < workerCount; ++offset) {
+        Slice& slice = slices[(worker + offset) % workerCount];
+        size_t end = slice.end.load(std::memory_order_relaxed);
+        while (true) {
+            size_t index = slice.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= end) break;
+            (*task)(index, worker);
+        }
+    }
+}
@@ -9,3 +9,8 @@ long long Timer::elapsed() const {
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count();
     return duration; // return in microseconds
 }
+
+long long Timer::elapsedNanoseconds() const {
+    auto now = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_time).count();
+}
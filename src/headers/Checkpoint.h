@@ -0,0 +1,87 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HugoStable.h"
+#include "ParticleSystem.h"
+#include "Simulation.h"
+
+// File layout, little endian, every block starting on an 8 byte boundary:
+//   CheckpointHeader
+//   CheckpointSetting[settingCount]      physics settings the run was started with
+//   char[rngStateSize]                   std::mt19937 state as written by operator<<
+//   double[particleCount] x, y, vx, vy, A, W, lockedMagnitude
+//   std::int32_t[particleCount] type, spin      velocity locks and spin strength come from PARTICLE_TRAITS[type]
+//   std::uint8_t[particleCount] isLocked
+//   std::uint64_t[particleCount] historyCount
+//   double[particleCount * historyCapacity * 2] history, oldest first, unused slots 0
+struct CheckpointHeader {
+    char magic[8];               // "GRAVCKP\0"
+    std::uint32_t version;
+    std::uint32_t settingCount;
+    std::uint64_t particleCount;
+    std::uint64_t historyCapacity;
+    std::int64_t step;
+    double tk;
+    double t;
+    std::uint8_t oscillating;
+    std::uint8_t increasing;
+    std::uint8_t reserved[2];
+    std::uint32_t seed;
+    std::uint64_t rngStateSize;
+};
+
+struct CheckpointSetting {
+    char name[32];
+    double value;
+};
+
+const std::uint32_t CHECKPOINT_VERSION = 2;
+
+// Everything a run needs to continue, copied out between two steps so the simulation can go on
+// while it is written
+struct CheckpointState {
+    CheckpointHeader header;
+    std::vector<CheckpointSetting> settings;
+    std::string rngState;
+    std::vector<char> particleData;  // the particle blocks of the file layout, ready to write
+
+    void capture(const ParticleSystem& particles, const StepClock& clock, long long step, unsigned int seed);
+};
+
+bool writeCheckpoint(const CheckpointState& state, const std::string& filename);
+
+// Maps the file and rebuilds the particles (into an empty ParticleSystem), the clock, the step counter,
+// the random engine and the stored physics settings
+bool loadCheckpoint(const std::string& filename, ParticleSystem& particles, StepClock& clock, long long& step, unsigned int& seed);
+
+// Writes checkpoints on a background thread, to filename.tmp and then renamed over filename so a crash
+// mid-write keeps the previous one. A checkpoint submitted while the last one is still being written
+// replaces any other waiting one, the simulation never waits for the disk.
+class CheckpointWriter {
+public:
+    ~CheckpointWriter();
+
+    void start(const std::string& filename);
+    void submit(CheckpointState& state);  // swaps state with the waiting slot
+    void stop();                          // writes what is waiting, then joins
+
+private:
+    void writerLoop();
+
+    std::string filename;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    CheckpointState waiting;
+    bool hasWaiting = false;
+    bool running = false;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,58 @@
+#ifndef FIELDGENERATOR_H
+#define FIELDGENERATOR_H
+
+#include <vector>
+
+#include "FieldGrid.h"
+#include "ParticleSystem.h"
+#include "SeparableField.h"
+#include "ThreadPool.h"
+
+// Fills the result grid tile by tile on the thread pool. Every tile is owned by exactly one task,
+// which walks the peaks in order and computes its own pixels, so no state is shared between tasks
+// and the output does not depend on the thread count.
+//
+// Tiles are only regenerated when a particle that reaches them moved: each particle keeps the position
+// the grid was last built with, and once it drifts more than tolerance pixels from it, every tile its window
+// or its Gaussian touches (at the old and at the new position) is marked dirty. With tolerance 0 the
+// grid matches a full recompute exactly; the grid must be left untouched between calls.
+//
+// generate() is instantiated for float and double grids. A generator caches the tiles of one grid, so
+// alternating between grids (of either precision) needs an invalidate() in between.
+class FieldGenerator {
+public:
+    static const int TILE_SIZE = 64;
+
+    template <typename Scalar>
+    void generate(BasicFieldGrid<Scalar>& grid, const ParticleSystem& peaks, double radius, bool separable, double t, double tolerance, ThreadPool& pool);
+
+    // Forget the cached tiles, the next generate() recomputes the whole grid
+    void invalidate();
+
+    // Largest value of the last generated grid, tracked per tile while the values are written
+    double maxValue() const;
+
+    size_t lastRecomputed() const;  // tiles the last generate() rebuilt
+
+private:
+    // cutoff is GaussianCutoff<Scalar>::exponent of the grid, past it a particle changes nothing
+    void markDirty(const GridGeometry& grid, const ParticleSystem& peaks, double radius, bool separable, double tolerance, double cutoff);
+    void markSquare(const GridGeometry& grid, double x, double y, double reach);
+    template <typename Scalar>
+    void generateTile(size_t tile, size_t worker, BasicFieldGrid<Scalar>& grid, const ParticleSystem& peaks, double radius, bool separable, double t);
+
+    std::vector<SeparableWindow> windows;  // one per worker, reused between steps
+    std::vector<double> tileMax;           // written by the task owning the tile
+    double max = 0.0;
+
+    std::vector<double> anchorX, anchorY;  // particle positions the cached tiles were built with
+    std::vector<char> dirty;               // per tile
+    std::vector<size_t> dirtyTiles;
+    double lastRadius = -1.0;
+    bool lastSeparable = false;
+    unsigned int lastWidth = 0, lastHeight = 0;
+    double lastScale = 0.0;
+    int tilesX = 0, tilesY = 0;  // tile (ti, tj) is index ti * tilesY + tj
+};
+
+#endif // FIELDGENERATOR_H
@@ -0,0 +1,64 @@
+#ifndef FIELDGRID_H
+#define FIELDGRID_H
+
+#include <cstddef>
+#include <vector>
+
+// Size and world-to-pixel mapping of a field grid, independent of the precision its values are kept in.
+// Pixel (i, j) sits at world ((i - width / 2) * scale, (j - height / 2) * scale), so scale is world units per pixel.
+class GridGeometry {
+public:
+    GridGeometry(unsigned int width, unsigned int height, double scale);
+
+    unsigned int width() const { return width_; }
+    unsigned int height() const { return height_; }
+    double scale() const { return scale_; }
+
+    // Full width and height of the covered world. The quadtree root takes them as its half extents, so it
+    // reaches half a grid past every edge and particles drifting off the field stay in the tree.
+    double worldWidth() const { return width_ * scale_; }
+    double worldHeight() const { return height_ * scale_; }
+
+    // World coordinate to pixel index, truncated towards zero (off-grid results are the caller's to reject)
+    int pixelX(double x) const { return static_cast<int>(x / scale_ + width_ / 2.0); }
+    int pixelY(double y) const { return static_cast<int>(y / scale_ + height_ / 2.0); }
+    bool contains(int i, int j) const { return i >= 0 && i < static_cast<int>(width_) && j >= 0 && j < static_cast<int>(height_); }
+
+protected:
+    unsigned int width_;
+    unsigned int height_;
+    double scale_;
+};
+
+// The sampled field, width x height values allocated once and owned by whoever runs the simulation.
+// Stored column by column like the old result[i][j] (i along x, j along y).
+template <typename Scalar>
+class BasicFieldGrid : public GridGeometry {
+public:
+    typedef Scalar value_type;
+
+    BasicFieldGrid(unsigned int width, unsigned int height, double scale)
+        : GridGeometry(width, height, scale), values(static_cast<size_t>(width_) * height_, Scalar(0)) {}
+
+    Scalar* column(int i) { return &values[static_cast<size_t>(i) * height_]; }
+    const Scalar* column(int i) const { return &values[static_cast<size_t>(i) * height_]; }
+    Scalar* data() { return values.data(); }
+    const Scalar* data() const { return values.data(); }
+    size_t size() const { return values.size(); }
+
+private:
+    std::vector<Scalar> values;
+};
+
+// Precision of the field a build runs with, chosen per target at compile time: GRAV_FIELD_FLOAT generates,
+// stores and renders the field in float, halving its memory traffic and doubling the SIMD width of the row
+// kernel. Positions, velocities and forces are integrated in double either way.
+#ifdef GRAV_FIELD_FLOAT
+typedef float FieldScalar;
+#else
+typedef double FieldScalar;
+#endif
+
+typedef BasicFieldGrid<FieldScalar> FieldGrid;
+
+#endif // FIELDGRID_H
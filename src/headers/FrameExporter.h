@@ -0,0 +1,66 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ExportFormat {
+    PNG = 0,  // one compressed out/frames/<step>.png per frame, encoded by every worker in parallel
+    RAW = 1   // every frame appended to out/frames.raw, one worker so the stream stays in order
+};
+
+// out/frames.raw: RawStreamHeader, then per frame a std::int64_t step followed by width * height RGBA bytes
+struct RawStreamHeader {
+    char magic[8];  // "GRAVRAW\0"
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t reserved;
+};
+
+// Encodes rendered frames on worker threads while the simulation keeps going. push() copies the frame into a
+// recycled buffer and returns; once queueCapacity frames are waiting it blocks until a worker is done with
+// one, so a slow disk slows the producer down instead of piling frames up in memory.
+class FrameExporter {
+public:
+    ~FrameExporter();
+
+    bool start(ExportFormat format, size_t workerCount, size_t queueCapacity, unsigned int width, unsigned int height);
+    void push(const std::uint8_t* rgba, long long step);
+    void stop();  // encodes everything still queued, then joins
+
+private:
+    struct Frame {
+        std::vector<std::uint8_t> pixels;
+        long long step = 0;
+    };
+
+    void workerLoop();
+    bool encode(const Frame& frame);
+
+    ExportFormat format = ExportFormat::PNG;
+    unsigned int width = 0, height = 0;
+    size_t capacity = 0;
+    std::FILE* stream = nullptr;  // RAW only
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::condition_variable slotFree;
+    std::deque<Frame> queued;
+    std::vector<Frame> spare;  // buffers handed back by the workers
+    size_t inFlight = 0;       // queued plus being encoded
+    bool running = false;
+
+    long long exported = 0;
+    long long failed = 0;
+    long long blockedMicroseconds = 0;  // producer time spent waiting for a free slot
+};
+
+#endif // FRAMEEXPORTER_H
@@ -0,0 +1,46 @@
+#ifndef FRAMESNAPSHOT_H
+#define FRAMESNAPSHOT_H
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "FieldGrid.h"
+#include "ParticleSystem.h"
+
+// Everything the Renderer reads for one frame, copied out of the simulation so drawing never
+// touches state the integrator is writing.
+struct FrameSnapshot {
+    std::vector<FieldScalar> field;  // copy of the FieldGrid values (column i at i * height), empty when the field is not drawn
+    double maxValue = 0.0;
+    std::vector<double> x, y;
+    std::vector<ParticleType> type;
+    std::vector<size_t> tailStart;                   // particle p's tail is tail[tailStart[p], tailStart[p + 1])
+    std::vector<std::pair<double, double>> tail;     // newest first
+    long long step = 0;
+    double tk = 0.0;
+
+    void capture(const FieldGrid& grid, double maxValue, bool withField, const ParticleSystem& particles, size_t tailLength, long long step, double tk);
+};
+
+// Latest-frame handoff from the simulation thread to the render thread through three slots: the producer
+// never waits, the consumer always gets the newest completed frame, frames it was too slow for are dropped.
+class FrameExchange {
+public:
+    FrameSnapshot& writeSlot();  // producer: fill this one, then publish()
+    void publish();
+
+    // Consumer: the newest frame published since the last call, nullptr when there is none.
+    // Stays valid until the next acquire().
+    const FrameSnapshot* acquire();
+
+private:
+    static const int FRESH = 4;  // set on middle when it holds a frame the consumer has not taken yet
+
+    FrameSnapshot slots[3];
+    int writing = 0;                 // producer only
+    int reading = 1;                 // consumer only
+    std::atomic<int> middle{2};
+};
+
+#endif // FRAMESNAPSHOT_H
@@ -0,0 +1,31 @@
+#ifndef GAUSSIANKERNEL_H
+#define GAUSSIANKERNEL_H
+
+#include <cstddef>
+
+// Scalar form of the SIMD exp() in the row kernel: range reduction to |r| <= ln2/2 and a degree 12
+// Taylor polynomial. Max relative error against std::exp is below 1e-15 on [-708, 0], inputs under -708 return 0.
+double fastExp(double x);
+
+// Single-precision counterpart: degree 7 polynomial, max relative error below 1e-7 on [-87, 0], inputs under -87 return 0.
+float fastExp(float x);
+
+// Exponent (dx^2 + dy^2) / 2W^2 past which a Gaussian term is dropped as 0 in Scalar. The row callers skip
+// particles on it, the field generator sizes a particle's reach from it and the SIMD exp returns 0 past it, so all
+// of them agree on what is exactly 0.
+template <typename Scalar> struct GaussianCutoff;
+template <> struct GaussianCutoff<double> { static constexpr double exponent = 708.0; };
+template <> struct GaussianCutoff<float> { static constexpr double exponent = 87.0; };
+
+// Row kernel of one particle's Gaussian, a = A2 * exp(-(dx2 + dy^2) * invTwoW2) with dy = dyStart + k * dyStep,
+// adds a * prefix[k] to pair[k] and then a to prefix[k] for k < count (the running pair sum of ParticleSystem::g0). Uses AVX2 or SSE4.1 when the build enables them;
+// the float specialization evaluates in float, twice the lanes per vector of the double one.
+template <typename Scalar>
+void accumulateGaussianRow(double A2, double invTwoW2, double dx2, double dyStart, double dyStep, size_t count, Scalar* prefix, Scalar* pair);
+
+template <>
+void accumulateGaussianRow<double>(double A2, double invTwoW2, double dx2, double dyStart, double dyStep, size_t count, double* prefix, double* pair);
+template <>
+void accumulateGaussianRow<float>(double A2, double invTwoW2, double dx2, double dyStart, double dyStep, size_t count, float* prefix, float* pair);
+
+#endif // GAUSSIANKERNEL_H
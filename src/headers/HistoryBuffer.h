@@ -0,0 +1,108 @@
+#ifndef HISTORYBUFFER_H
+#define HISTORYBUFFER_H
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Non-owning view of one particle's history, newest position first. The ring wraps at most once,
+// so the view is the newest run [0, firstCount) followed by the older run [0, secondCount).
+class HistoryView {
+public:
+    typedef std::pair<double, double> Position;
+
+    HistoryView() = default;
+    HistoryView(const Position* first, size_t firstCount, const Position* second, size_t secondCount)
+        : first_(first), firstCount_(firstCount), second_(second), secondCount_(secondCount) {}
+
+    size_t size() const { return firstCount_ + secondCount_; }
+    bool empty() const { return size() == 0; }
+
+    // 0 = newest
+    const Position& operator[](size_t i) const {
+        return i < firstCount_ ? first_[firstCount_ - 1 - i] : second_[secondCount_ - 1 - (i - firstCount_)];
+    }
+
+    // The newest count entries only, the rest of the ring is never touched
+    HistoryView newest(size_t count) const {
+        if (count >= size()) return *this;
+        if (count <= firstCount_) return HistoryView(first_ + firstCount_ - count, count, nullptr, 0);
+        size_t fromSecond = count - firstCount_;
+        return HistoryView(first_, firstCount_, second_ + secondCount_ - fromSecond, fromSecond);
+    }
+
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Position value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Position* pointer;
+        typedef const Position& reference;
+
+        const_iterator(const HistoryView* view, size_t index) : view(view), index(index) {}
+        const Position& operator*() const { return (*view)[index]; }
+        const Position* operator->() const { return &(*view)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++index; return old; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+    private:
+        const HistoryView* view;
+        size_t index;
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    const Position* first_ = nullptr;
+    size_t firstCount_ = 0;
+    const Position* second_ = nullptr;
+    size_t secondCount_ = 0;
+};
+
+// Position history of every particle in one contiguous block: particle p owns the fixed ring
+// slots [p * capacity, (p + 1) * capacity), so a push never allocates or shifts anything.
+class HistoryBuffer {
+public:
+    typedef HistoryView::Position Position;
+
+    explicit HistoryBuffer(size_t capacity);
+
+    size_t capacity() const { return capacity_; }
+
+    // Appends a ring for one more particle, seeded with its oldest-first history (only the newest capacity kept)
+    void addParticle(const std::vector<Position>& initial);
+
+    // Only the thread updating the particle writes its ring
+    void push(size_t particle, double x, double y);
+
+    HistoryView view(size_t particle) const;              // newest first
+    std::vector<Position> copy(size_t particle) const;   // oldest first, like Particle's history
+
+private:
+    size_t capacity_;
+    std::vector<Position> slots;
+    std::vector<size_t> head;   // slot of the next write, relative to the particle's ring
+    std::vector<size_t> count;
+};
+
+inline void HistoryBuffer::push(size_t particle, double x, double y) {
+    slots[particle * capacity_ + head[particle]] = Position(x, y);
+    head[particle] = head[particle] + 1 == capacity_ ? 0 : head[particle] + 1;
+    if (count[particle] < capacity_) ++count[particle];
+}
+
+inline HistoryView HistoryBuffer::view(size_t particle) const {
+    const Position* ring = slots.data() + particle * capacity_;
+    size_t newest = head[particle];
+    size_t n = count[particle];
+    if (n <= newest) return HistoryView(ring + newest - n, n, nullptr, 0);
+    // Wrapped: [0, head) is newer than the tail end [capacity - (n - head), capacity)
+    size_t older = n - newest;
+    return HistoryView(ring, newest, ring + capacity_ - older, older);
+}
+
+#endif // HISTORYBUFFER_H
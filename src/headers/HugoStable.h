@@ -1,10 +1,12 @@
 #pragma once
 
-const unsigned int HUGO_STABLE = 1000;  //ilość iteracji musi sie równać powieszchni liczonej
-const double chunkiBoi = 0.001; // This will act as a multiplier. If it's 1.0, it means no reduction. If it's 0.5, the velocity change will be halved.
+const double G = 6.674e-11;  // Placeholder for Gravitational constant (You might want to adjust this for your simulation)
+constexpr double chunkiBoi = 0.001; // This will act as a multiplier. If it's 1.0, it means no reduction. If it's 0.5, the velocity change will be halved.
 
+// Per-type behaviour lives in PARTICLE_TRAITS (ParticleTraits.h), one row per entry here
 enum ParticleType {
-    A1, A2, A3
+    A1, A2, A3,
+    PARTICLE_TYPE_COUNT
 };
 
 enum Spin {
@@ -0,0 +1,87 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "HugoStable.h"
+#include "ParticleTraits.h"
+#include "FieldGrid.h"
+#include "Particle.h"
+#include "Telemetry.h"
+#include "HistoryBuffer.h"
+
+class QuadTree;
+
+// Structure-of-arrays particle store, the field and force kernels run directly over these arrays.
+// Particle stays the per-particle description used to spawn particles and to read one back.
+//
+// Particles are kept bucketed by type, in ParticleType order, so each bucket is updated by its own
+// updatePosition<Type> with the type's traits as compile-time constants.
+class ParticleSystem {
+public:
+    typedef void (ParticleSystem::*UpdateKernel)(size_t, const QuadTree&, double, double, double, const FieldGrid&, bool, double, Telemetry&);
+
+    // historyCapacity positions are kept per particle, preallocated when the particle is added
+    explicit ParticleSystem(size_t historyCapacity = Particle::MAX_HISTORY_SIZE);
+
+    void add(const Particle& particle);  // appends, groupByType() restores the buckets
+    size_t size() const;
+
+    // Stable sort by type (a no-op when nothing was added out of order) and recompute the buckets;
+    // bucket Type is [bucketBegin(Type), bucketEnd(Type)) until the next add(). True when particles moved.
+    bool groupByType();
+    size_t bucketBegin(ParticleType type) const { return bucketStart[type]; }
+    size_t bucketEnd(ParticleType type) const { return bucketStart[type + 1]; }
+
+    Particle particle(size_t i) const;  // copy of particle i, for callers outside the hot loops
+
+    double valueAt(size_t i, double x, double y, double t) const;
+    double g0(double x, double y, double t) const;
+    // g0 at (x, yStart + k * yStep) for k < count, one SIMD Gaussian row per particle; matches a FieldGrid column.
+    // Evaluated and summed in Scalar (float or double), the particle data stays double.
+    template <typename Scalar>
+    void g0Row(double x, double yStart, double yStep, size_t count, double t, Scalar* out) const;
+    // Closed-form gradient of g0 at any point, on or off the grid, O(size())
+    void g0Gradient(double x, double y, double t, double& gradientX, double& gradientY) const;
+    // Reads the current buffers, writes particle i's next state; safe to run for all i in parallel.
+    // analyticGradient = use g0Gradient at the particle, otherwise central differences on the grid.
+    // i must be of type Type; updateKernel(type) is the same function for a type known only at run time.
+    template <ParticleType Type>
+    void updatePosition(size_t i, const QuadTree& qtree, double theta, double t, double k, const FieldGrid& grid, bool analyticGradient, double tk, Telemetry& telemetry);
+    static UpdateKernel updateKernel(ParticleType type);
+    // Any particle, through updateKernel(type[i])
+    void updatePosition(size_t i, const QuadTree& qtree, double theta, double t, double k, const FieldGrid& grid, bool analyticGradient, double tk, Telemetry& telemetry);
+    void swapBuffers();  // publish the next state once every particle has been updated
+
+    // Hot data, touched by every kernel
+    std::vector<double> x, y;
+    std::vector<double> vx, vy;
+    std::vector<double> A, W;
+    std::vector<double> invTwoWSquared;  // 1 / (2 W^2), fixed when the particle is added
+    std::vector<ParticleType> type;
+
+    // Cold data, only touched by updatePosition and the tail renderer
+    std::vector<Spin> spin;
+    std::vector<char> isLocked;
+    std::vector<double> lockedMagnitude;
+    HistoryBuffer history;  // each particle's ring is only written by its own updatePosition
+
+    // Next-state buffers written by updatePosition, swapped in by swapBuffers
+    std::vector<double> nextX, nextY;
+    std::vector<double> nextVX, nextVY;
+    std::vector<char> nextIsLocked;
+    std::vector<double> nextLockedMagnitude;
+
+private:
+    std::array<size_t, PARTICLE_TYPE_COUNT + 1> bucketStart = {};
+};
+
+inline double ParticleSystem::valueAt(size_t i, double px, double py, double t) const {
+    double dx = px - x[i];
+    double dy = py - y[i];
+    return A[i] * A[i] * exp(-(dx * dx + dy * dy) * invTwoWSquared[i]);
+}
+
+#endif // PARTICLESYSTEM_H
@@ -0,0 +1,33 @@
+#ifndef PARTICLETRAITS_H
+#define PARTICLETRAITS_H
+
+#include <cstdint>
+
+#include "HugoStable.h"
+
+// Everything that differs between particle types. Adding a type is an enum entry in HugoStable.h and its row
+// here; Particle, the update kernels, spawning, the settings keys and the renderer read these values and branch
+// on nothing else.
+struct ParticleTraits {
+    double velocityLockX, velocityLockY;  // cap on one step's velocity change, and the speed past which it locks
+    double spinStrength;                   // sideways push per unit t, direction from the particle's Spin
+    double gradientScale;                  // multiplies the field's velocity change
+    std::uint8_t red, green, blue;         // tail and dot colour
+    double spawnMin, spawnMax;             // spawned at x and y drawn from [spawnMin, spawnMax]
+    double spawnSpeed;                     // with vx and vy drawn from [-spawnSpeed, spawnSpeed]
+    double count, mass, width;             // defaults of TYPE<n>_COUNT, MASS<n> and W<n>, n = type + 1
+};
+
+constexpr ParticleTraits PARTICLE_TRAITS[] = {
+    { 1.0, 1.0, 0.01, 1.0, 255, 0, 0, -5.0, -4.0, 0.1, 5, 5, 5 },                // A1, medium
+    { 30.0, 30.0, 0.01, 1.0, 0, 255, 0, -5.0, -4.0, 0.1, 5, 10, 10 },            // A2, small
+    { 0.001, 0.001, 0.0001, chunkiBoi, 0, 0, 255, -10.0, 10.0, 0.0, 1, 10, 10 },  // A3, chunki boi, only one!
+};
+
+static_assert(sizeof(PARTICLE_TRAITS) / sizeof(PARTICLE_TRAITS[0]) == PARTICLE_TYPE_COUNT, "one PARTICLE_TRAITS row per ParticleType");
+
+constexpr const ParticleTraits& traitsOf(ParticleType type) {
+    return PARTICLE_TRAITS[type];
+}
+
+#endif // PARTICLETRAITS_H
@@ -0,0 +1,105 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped hot-path zones: PROFILE_ZONE("name") times the rest of the enclosing scope, PROFILE_FRAME() closes
+// a simulation step and PROFILE_REPORT(file) prints the per-zone statistics and writes a Chrome trace.
+// Only compiled in with -DGRAV_PROFILE=ON, otherwise every macro expands to nothing.
+#ifdef GRAV_PROFILE
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Timer.h"
+
+class Profiler {
+public:
+    static Profiler& instance();
+
+    long long now() const;  // nanoseconds since the profiler was created
+    void record(const char* name, long long start, long long duration);
+
+    // Folds the events every thread recorded since the last call into the per-zone frame statistics
+    void endFrame();
+
+    // Per zone over all frames it ran in: min/mean/p99 of its per-frame time (summed over threads)
+    void report(std::ostream& out) const;
+    // Complete ("X") events readable by chrome://tracing and Perfetto
+    bool writeChromeTrace(const std::string& filename) const;
+
+private:
+    static const size_t MAX_TRACE_EVENTS = 1 << 20;  // later events are only counted in the statistics
+
+    struct Event {
+        const char* name;
+        long long start;
+        long long duration;
+    };
+
+    // Written by its own thread only, the mutex just makes endFrame safe against a zone still closing
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        unsigned int thread = 0;
+    };
+
+    struct TraceEvent {
+        Event event;
+        unsigned int thread;
+    };
+
+    struct ZoneStats {
+        std::vector<double> frameTimes;  // microseconds, one entry per frame the zone ran in
+        size_t calls = 0;
+    };
+
+    ThreadBuffer& localBuffer();
+
+    Timer clock;
+    mutable std::mutex mutex;  // buffers, zones, trace
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::map<std::string, ZoneStats> zones;
+    std::vector<TraceEvent> trace;
+    std::vector<Event> scratch;
+    size_t frames = 0;
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), start(Profiler::instance().now()) {}
+    ~ProfileZone() {
+        Profiler& profiler = Profiler::instance();
+        profiler.record(name, start, profiler.now() - start);
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    long long start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FRAME() Profiler::instance().endFrame()
+#define PROFILE_REPORT(traceFile) \
+    do { \
+        Profiler::instance().endFrame(); \
+        Profiler::instance().report(std::cerr); \
+        Profiler::instance().writeChromeTrace(traceFile); \
+    } while (0)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_REPORT(traceFile) ((void)0)
+
+#endif // GRAV_PROFILE
+
+#endif // PROFILER_H
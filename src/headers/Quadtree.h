@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "Particle.h"
+#include "ParticleSystem.h"
 
 // Define the boundary for each node in the QuadTree
 class Boundary {
@@ -12,45 +13,58 @@ public:
     Boundary(double x, double y, double w, double h);
 
     bool contains(const Particle& particle) const;
+    bool contains(double px, double py) const;
     bool intersects(const Boundary& other) const;
 };
 
-// Node class for QuadTree
-class QuadTreeNode {
-public:
-    QuadTreeNode(Boundary boundary, size_t capacity);
-    ~QuadTreeNode();
-
-    // Operations
-    bool insert(Particle* particle);
-    void subdivide();
-
-    // Fetch all particles in the boundary
-    void query(const Boundary& range, std::vector<Particle*>& found) const;
+// Node stored in the QuadTree pool. Children are indices into the same pool and
+// particles are indices into the ParticleSystem the tree was built from, so a node never allocates.
+struct QuadTreeNode {
+    static const unsigned int CAPACITY = 4;
 
-    // Attributes
     Boundary boundary;
-    size_t capacity;
-    std::vector<Particle*> particles;
+    int firstChild = -1;  // northwest, northeast, southwest, southeast follow at firstChild..firstChild + 3
+    int next = -1;        // overflow node with the same boundary, only used at MAX_DEPTH
+    unsigned int count = 0;
+    unsigned int items[CAPACITY];
 
-    QuadTreeNode* northwest = nullptr;
-    QuadTreeNode* northeast = nullptr;
-    QuadTreeNode* southwest = nullptr;
-    QuadTreeNode* southeast = nullptr;
+    // Barnes-Hut aggregates ("mass" as in valueAt at the particle itself)
+    double mass = 0.0;
+    double centerX = 0.0;
+    double centerY = 0.0;
+
+    explicit QuadTreeNode(Boundary boundary) : boundary(boundary) {}
 };
 
-// Main QuadTree class
+// Main QuadTree class, all nodes live in one contiguous arena that is reused between steps
 class QuadTree {
 public:
-    QuadTree(Boundary boundary, size_t capacity);
-    ~QuadTree();
+    static const int MAX_DEPTH = 32;
+
+    explicit QuadTree(Boundary boundary);
 
-    void insert(Particle* particle);
-    void clear();
-    void query(const Boundary& range, std::vector<Particle*>& found) const;
+    // Drop the previous contents and insert every particle
+    void build(const ParticleSystem& particles);
+
+    bool insert(unsigned int index);
+    void clear();  // O(1), keeps the arena storage
+    void query(const Boundary& range, std::vector<unsigned int>& found) const;
+
+    // Fill mass/centre of mass bottom-up, call once after all inserts
+    void computeMassDistribution(double t);
+
+    // Barnes-Hut walk: far cells (size / distance < theta) add their aggregated pull, towards the cell, to
+    // force_x/force_y, particles of opened cells are returned in direct for exact pairing
+    void accumulateForce(unsigned int target, double theta, double t, double& force_x, double& force_y, std::vector<unsigned int>& direct) const;
 
 private:
-    QuadTreeNode* root;
+    int allocate(const Boundary& boundary);
+    void subdivide(int node);
+
+    Boundary rootBoundary;
+    std::vector<QuadTreeNode> nodes;
+    size_t used = 0;
+    const ParticleSystem* particles = nullptr;
 };
 
 #endif // QUADTREE_H
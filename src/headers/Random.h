@@ -0,0 +1,14 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <random>
+
+// Process-wide generator behind every random draw (spawn positions, velocities, spin), seeded from SEED
+std::mt19937& randomEngine();
+
+// 0 picks a seed from std::random_device; returns the seed actually used so the run can be repeated
+unsigned int seedRandom(unsigned int seed);
+
+double getRandomDouble(double min, double max);
+
+#endif // RANDOM_H
@@ -0,0 +1,57 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <climits>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "HugoStable.h"
+#include "FieldGrid.h"
+#include "FrameSnapshot.h"
+
+// Keeps one RGBA frame buffer and one texture for the whole run. draw() rewrites the buffer, present()
+// uploads only the rectangle that changed since the last upload and shows it.
+class Renderer {
+public:
+    explicit Renderer(const GridGeometry& grid);  // one pixel per grid cell, same world-to-pixel mapping
+
+    // Field (normalize and colormap in one pass), tails and dots; false when the frame carries a field that is all zero.
+    // frame.maxValue is the grid maximum FieldGenerator tracked while writing result.
+    bool draw(const FrameSnapshot& frame);
+
+    void present(sf::RenderWindow& window);
+
+    const sf::Uint8* pixels() const;  // width x height RGBA, row-major, what FrameExporter copies
+    unsigned int width() const { return width_; }
+    unsigned int height() const { return height_; }
+
+private:
+    struct DirtyRect {
+        int left = INT_MAX, top = INT_MAX, right = 0, bottom = 0;  // right/bottom exclusive
+
+        bool empty() const { return left >= right || top >= bottom; }
+        void add(int x, int y);
+        void add(const DirtyRect& other);
+        void setFull(int width, int height);
+    };
+
+    bool isFull(const DirtyRect& rect) const;
+
+    void drawField(const FieldScalar* field, double max_value);
+    void clear(const DirtyRect& rect);
+    void setPixel(double worldX, double worldY, sf::Color color);  // skips pixels off the grid, grows drawn
+
+    unsigned int width_, height_;
+    double scale;
+
+    std::vector<sf::Uint8> buffer;
+    std::vector<sf::Uint8> staging;  // dirty rectangle packed for texture.update
+    sf::Texture texture;
+    sf::Sprite sprite;
+    bool textureCreated = false;
+    bool fieldDrawn = false;  // the last frame covered every pixel with the field
+    DirtyRect drawn;          // particle pixels of the last frame, cleared before the next one without the field
+    DirtyRect dirty;          // changed since the last present
+};
+
+#endif // RENDERER_H
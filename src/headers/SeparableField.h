@@ -0,0 +1,27 @@
+#ifndef SEPARABLEFIELD_H
+#define SEPARABLEFIELD_H
+
+#include <vector>
+
+#include "ParticleSystem.h"
+
+// exp(-(dx^2 + dy^2) / 2W^2) == exp(-dx^2 / 2W^2) * exp(-dy^2 / 2W^2), so inside one render
+// window every particle only needs a column and a row of factors; pixels are built from their products.
+class SeparableWindow {
+public:
+    // Tabulate factors for the window sampled at (xStart + a * step, yStart + b * step), a < width, b < height
+    void compute(const ParticleSystem& particles, double xStart, double yStart, double step, size_t width, size_t height, double t);
+
+    // g0 at window column a for rows bStart .. bStart + count - 1, summed in Scalar; the factors stay double
+    template <typename Scalar>
+    void g0Row(size_t a, size_t bStart, size_t count, Scalar* out) const;
+
+private:
+    size_t width = 0;
+    size_t height = 0;
+    size_t particleCount = 0;
+    std::vector<double> factorX;  // particle-major, A^2 folded in: factorX[p * width + a]
+    std::vector<double> factorY;  // particle-major: factorY[p * height + b]
+};
+
+#endif // SEPARABLEFIELD_H
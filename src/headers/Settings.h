@@ -0,0 +1,51 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <array>
+#include <string>
+
+#include "HugoStable.h"
+
+// Simulation settings, defaults in Settings.cpp, overridden by the KEY=value lines of properties.txt
+typedef std::array<double, PARTICLE_TYPE_COUNT> PerType;  // indexed by ParticleType
+extern PerType TYPE_COUNT;  // keys TYPE<n>_COUNT, MASS<n> and W<n> with n = type + 1, defaults from PARTICLE_TRAITS
+extern PerType TYPE_MASS;
+extern PerType TYPE_WIDTH;
+extern double TAIL_CUTOFF;
+extern double RENDER_GRAVITY_RADIUS;
+extern double GRID_WIDTH;
+extern double GRID_HEIGHT;
+extern double GRID_SCALE;
+extern double SHOW_GRAV;
+extern double THETA;
+extern double SEPARABLE_FIELD;
+extern double FIELD_TOLERANCE;
+extern double ANALYTIC_GRADIENT;
+extern double THREADS;
+extern double HEADLESS;
+extern double STEPS;
+extern double SIM_TIME;
+extern double FRAME_EVERY;
+extern double TELEMETRY_INTERACTIONS;
+extern double TELEMETRY_INTERACTIONS_SAMPLE;
+extern double TELEMETRY_STEPS;
+extern double TELEMETRY_STEPS_SAMPLE;
+extern double SUBSTEPS;
+extern double FRAME_BUDGET_MS;
+extern double CHECKPOINT_EVERY;
+extern double EXPORT_EVERY;
+extern double EXPORT_FORMAT;
+extern double EXPORT_THREADS;
+extern double SEED;
+extern double TIME_SCALE;
+extern double k;
+
+bool readSettingsFromFile(const std::string& filename,
+                          double& TIME_SCALE, double& k);
+
+// TYPE<n>_COUNT, MASS<n> and W<n> of one type, and the TYPE_COUNT/TYPE_MASS/TYPE_WIDTH slot a key names
+// (nullptr for any other key)
+std::array<std::string, 3> typeSettingKeys(ParticleType type);
+double* typeSetting(const std::string& key);
+
+#endif // SETTINGS_H
@@ -0,0 +1,31 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "FieldGrid.h"
+#include "ParticleSystem.h"
+#include "Quadtree.h"
+#include "FieldGenerator.h"
+#include "ThreadPool.h"
+#include "Telemetry.h"
+
+// Spawns TYPE1/2/3_COUNT particles from the shared random engine, seed it first for a repeatable run
+void spawnParticles(ParticleSystem& particles);
+
+// Time of the main loop: tk grows by TIME_SCALE every step, t ramps up to 0.3 and then oscillates just below it.
+// beginStep() before generateData, endStep() after everything else of the step.
+struct StepClock {
+    double tk = 0;
+    double t = 0;
+    bool oscillating = false;
+    bool increasing = true;
+
+    void beginStep();
+    void endStep();
+};
+
+// One simulation step: field into the grid, quadtree rebuild, then every particle updated from the previous state.
+// With ANALYTIC_GRADIENT the physics never reads the grid, so the field is only generated when withField is set
+// (a frame that shows the field is captured after this step); otherwise it is generated every step.
+void generateData(double t, FieldGrid& grid, ParticleSystem& peaks, QuadTree& qtree, FieldGenerator& field, ThreadPool& pool, Telemetry& telemetry, double tk, bool withField);
+
+#endif // SIMULATION_H
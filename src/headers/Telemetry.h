@@ -0,0 +1,85 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+enum TelemetryChannel : std::uint32_t {
+    CHANNEL_INTERACTIONS = 0,  // one record per exact particle pair in updatePosition
+    CHANNEL_STEPS = 1,         // one record per simulation step
+    CHANNEL_COUNT
+};
+
+// Fixed-size record, written to the file exactly as laid out here
+struct TelemetryRecord {
+    double tk;
+    double value;            // interactions: velocity magnitude, steps: step time in microseconds
+    std::uint32_t channel;
+    std::uint32_t particle;  // interactions: particle index, steps: step number
+    std::int32_t tag;        // interactions: neighbour ParticleType, steps: particle count
+    std::uint32_t reserved;
+};
+
+struct TelemetryFileHeader {
+    char magic[8];           // "GRAVTLM\0"
+    std::uint32_t version;
+    std::uint32_t recordSize;
+};
+
+const std::uint32_t TELEMETRY_VERSION = 1;
+
+// Producers push records into a bounded lock-free ring (never blocking, full ring drops the record)
+// and a background thread drains it into a binary file, see tools/TelemetryToCsv.cpp for reading it.
+class Telemetry {
+public:
+    Telemetry();
+    ~Telemetry();
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    // sampleEvery = N keeps every Nth record of the channel
+    void enable(TelemetryChannel channel, std::uint32_t sampleEvery);
+    bool start(const std::string& filename);  // no-op returning true when every channel is disabled
+    void stop();                              // drains what is left and closes the file
+
+    bool enabled(TelemetryChannel channel) const;
+    void record(TelemetryChannel channel, std::uint32_t particle, std::int32_t tag, double value, double tk);
+
+    std::uint64_t dropped() const;
+
+private:
+    static const size_t CAPACITY = 1 << 18;  // records (8 MB), power of two
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        TelemetryRecord record;
+    };
+
+    bool tryPush(const TelemetryRecord& record);
+    bool tryPop(TelemetryRecord& record);
+    void writerLoop();
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) size_t dequeuePos = 0;  // writer thread only
+
+    bool channelEnabled[CHANNEL_COUNT] = { false };
+    std::uint32_t sampleEvery[CHANNEL_COUNT] = { 1, 1 };
+    std::atomic<std::uint64_t> sampleCounter[CHANNEL_COUNT];
+    std::atomic<std::uint64_t> droppedCount{0};
+
+    std::FILE* file = nullptr;
+    std::thread writer;
+    std::atomic<bool> running{false};
+};
+
+inline bool Telemetry::enabled(TelemetryChannel channel) const {
+    return running.load(std::memory_order_relaxed) && channelEnabled[channel];
+}
+
+#endif // TELEMETRY_H
@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool for data-parallel loops. Every worker (the calling thread included) starts on its own
+// slice of the index range and steals from the other slices once its own is empty.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount);  // 0 = std::thread::hardware_concurrency()
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const;  // workers including the calling thread
+
+    // Run task(index, worker) for every index in [0, count), returns when all of them finished
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& task);
+
+private:
+    struct alignas(64) Slice {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> end{0};
+    };
+
+    void workerLoop(size_t worker);
+    void drain(size_t worker);
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<Slice[]> slices;
+    size_t workerCount;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t, size_t)>* task = nullptr;
+    size_t generation = 0;
+    size_t finished = 0;
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
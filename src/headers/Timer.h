@@ -8,6 +8,7 @@ class Timer {
 public:
     Timer();
     long long elapsed() const; // returns microseconds
+    long long elapsedNanoseconds() const;
 };
 
 #endif // TIMER_H
\ No newline at end of file
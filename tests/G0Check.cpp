@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ParticleSystem.h"
+#include "SeparableField.h"
+
+// Checks every g0 evaluator against the O(N^2) reference Particle::g0Pairwise over random particles and points,
+// including a case where one particle dominates every pixel (where ((sum a)^2 - sum a^2) / 2 used to cancel to
+// garbage). Double results must match within DOUBLE_TOLERANCE relative error per point; the float row kernel
+// within FLOAT_TOLERANCE of the largest value of the case. ParticleSystem::g0Gradient is checked against the
+// pairwise sum of grad(a_i a_j), relative to the sum of the terms' magnitudes. Exits 1 on any failure.
+
+namespace {
+
+const double DOUBLE_TOLERANCE = 1e-12;
+const double FLOAT_TOLERANCE = 1e-5;
+const double SMALLEST = 1e-280;  // below this the reference is all underflowed terms, compared absolutely
+const double T = 0.1;
+const size_t ROW = 300;          // more than one 256 block, with a SIMD tail
+
+struct Case {
+    std::string name;
+    std::vector<Particle> particles;
+    double x0, x1, y0, y1;  // points are sampled in this box
+};
+
+double relativeError(double value, double reference) {
+    if (std::abs(reference) < SMALLEST) return std::abs(value - reference) < SMALLEST ? 0.0 : 1.0;
+    return std::abs(value - reference) / std::abs(reference);
+}
+
+// Pairwise gradient of g0, and the sum of |term| per component to scale its error by
+void gradientPairwise(double x, double y, const std::vector<Particle>& particles, double t, double gradient[2], double magnitude[2]) {
+    gradient[0] = gradient[1] = magnitude[0] = magnitude[1] = 0.0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+        double ai = particles[i].valueAt(x, y, t);
+        double wi = particles[i].getW() * particles[i].getW();
+        double gi[2] = { -(x - particles[i].getX()) / wi * ai, -(y - particles[i].getY()) / wi * ai };
+        for (size_t j = i + 1; j < particles.size(); ++j) {
+            double aj = particles[j].valueAt(x, y, t);
+            double wj = particles[j].getW() * particles[j].getW();
+            double gj[2] = { -(x - particles[j].getX()) / wj * aj, -(y - particles[j].getY()) / wj * aj };
+            for (int c = 0; c < 2; ++c) {
+                double term = gi[c] * aj + ai * gj[c];
+                gradient[c] += term;
+                magnitude[c] += std::abs(term);
+            }
+        }
+    }
+}
+
+double gradientError(double value, double reference, double magnitude) {
+    if (magnitude < SMALLEST) return std::abs(value - reference) < SMALLEST ? 0.0 : 1.0;
+    return std::abs(value - reference) / magnitude;
+}
+
+bool report(const std::string& name, const std::string& evaluator, double error, double tolerance) {
+    bool pass = error <= tolerance;
+    std::cout << name << ";" << evaluator << ";" << error << ";" << tolerance << ";" << (pass ? "PASS" : "FAIL") << std::endl;
+    return pass;
+}
+
+bool check(const Case& c, std::mt19937& gen) {
+    ParticleSystem system;
+    for (const Particle& particle : c.particles) {
+        system.add(particle);
+    }
+    std::uniform_real_distribution<> px(c.x0, c.x1);
+    std::uniform_real_distribution<> py(c.y0, c.y1);
+
+    double particleError = 0.0, systemError = 0.0, rowError = 0.0, separableError = 0.0;
+    double floatError = 0.0, largest = 0.0, gradientMaxError = 0.0;
+    std::vector<double> row(ROW), separable(ROW);
+    std::vector<float> floatRow(ROW);
+    SeparableWindow window;
+
+    for (int column = 0; column < 8; ++column) {
+        double x = px(gen);
+        double yStart = py(gen);
+        double step = (c.y1 - c.y0) / ROW;
+        system.g0Row(x, yStart, step, ROW, T, row.data());
+        system.g0Row(x, yStart, step, ROW, T, floatRow.data());
+        window.compute(system, x, yStart, step, 1, ROW, T);
+        window.g0Row(0, 0, ROW, separable.data());
+
+        for (size_t k = 0; k < ROW; ++k) {
+            double y = yStart + k * step;
+            double reference = Particle::g0Pairwise(x, y, c.particles, T);
+            particleError = std::max(particleError, relativeError(Particle::g0(x, y, c.particles, T), reference));
+            systemError = std::max(systemError, relativeError(system.g0(x, y, T), reference));
+            rowError = std::max(rowError, relativeError(row[k], reference));
+            separableError = std::max(separableError, relativeError(separable[k], reference));
+            floatError = std::max(floatError, std::abs(floatRow[k] - reference));
+            largest = std::max(largest, std::abs(reference));
+
+            double gradient[2], referenceGradient[2], magnitude[2];
+            system.g0Gradient(x, y, T, gradient[0], gradient[1]);
+            gradientPairwise(x, y, c.particles, T, referenceGradient, magnitude);
+            for (int component = 0; component < 2; ++component) {
+                gradientMaxError = std::max(gradientMaxError, gradientError(gradient[component], referenceGradient[component], magnitude[component]));
+            }
+        }
+    }
+    if (largest > 0.0) floatError /= largest;
+
+    bool pass = report(c.name, "Particle::g0", particleError, DOUBLE_TOLERANCE);
+    pass = report(c.name, "ParticleSystem::g0", systemError, DOUBLE_TOLERANCE) && pass;
+    pass = report(c.name, "ParticleSystem::g0Row<double>", rowError, DOUBLE_TOLERANCE) && pass;
+    pass = report(c.name, "SeparableWindow::g0Row<double>", separableError, DOUBLE_TOLERANCE) && pass;
+    pass = report(c.name, "ParticleSystem::g0Row<float>", floatError, FLOAT_TOLERANCE) && pass;
+    pass = report(c.name, "ParticleSystem::g0Gradient", gradientMaxError, DOUBLE_TOLERANCE) && pass;
+    return pass;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 gen(1);
+    std::vector<Case> cases;
+
+    // Comparable particles overlapping each other
+    {
+        std::uniform_real_distribution<> amplitude(1.0, 22.0);
+        std::uniform_real_distribution<> width(5.0, 100.0);
+        std::uniform_real_distribution<> position(-20.0, 20.0);
+        Case c{ "random", {}, -60.0, 60.0, -60.0, 60.0 };
+        for (int i = 0; i < 40; ++i) {
+            c.particles.push_back(Particle(amplitude(gen), width(gen), position(gen), position(gen), ParticleType::A1));
+        }
+        cases.push_back(c);
+    }
+
+    // One wide, heavy particle at the centre and narrow light ones far away: every pair sum is the big a
+    // times terms 1e-17 and smaller, which (S^2 - sum a^2) / 2 rounds to 0 or below
+    {
+        std::uniform_real_distribution<> amplitude(1e-3, 1.0);
+        std::uniform_real_distribution<> angle(0.0, 6.283185307179586);
+        std::uniform_real_distribution<> distance(80.0, 120.0);
+        Case c{ "dominant", {}, -10.0, 10.0, -10.0, 10.0 };
+        c.particles.push_back(Particle(22.0, 50.0, 0.0, 0.0, ParticleType::A3));
+        for (int i = 0; i < 6; ++i) {
+            double a = angle(gen), d = distance(gen);
+            c.particles.push_back(Particle(amplitude(gen), 8.0, d * std::cos(a), d * std::sin(a), ParticleType::A2));
+        }
+        cases.push_back(c);
+    }
+
+    std::cout << "case;evaluator;max_error;tolerance;result" << std::endl;
+    bool pass = true;
+    for (const Case& c : cases) {
+        pass = check(c, gen) && pass;
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "Settings.h"
+#include "Simulation.h"
+#include "Random.h"
+#include "Timer.h"
+
+// Accuracy report of the float field against the double baseline: runs the simulation headless from a fixed
+// SEED and at evenly spaced steps regenerates the whole field once in double and once in float for the same
+// particles, then compares the values, the rendered gray levels and the grid gradient the forces would read.
+// Usage: field_accuracy <properties.txt> [tolerance, default 1e-3] [samples, default 10]
+// Prints step;double_us;float_us;speedup;max_field_error;pixels_off;max_level_diff;max_gradient_error per sample.
+// Field error is |float - double| over the double maximum, gradient error is over the largest double gradient
+// at any particle; exits 1 when either passes the tolerance. The float trajectory itself is checked with
+// golden_trajectory_f32 compare against a file recorded by golden_trajectory.
+
+namespace {
+
+// Central differences at (x, y), as ParticleSystem::updatePosition takes them from the grid
+template <typename Scalar>
+void gridGradient(const BasicFieldGrid<Scalar>& grid, double x, double y, double& gradientX, double& gradientY) {
+    int i = grid.pixelX(x);
+    int j = grid.pixelY(y);
+    double spacing = 2.0 * grid.scale();
+    gradientX = 0.0;
+    gradientY = 0.0;
+    if (grid.contains(i - 1, j) && grid.contains(i + 1, j)) {
+        gradientX = (static_cast<double>(grid.column(i + 1)[j]) - grid.column(i - 1)[j]) / spacing;
+    }
+    if (grid.contains(i, j - 1) && grid.contains(i, j + 1)) {
+        gradientY = (static_cast<double>(grid.column(i)[j + 1]) - grid.column(i)[j - 1]) / spacing;
+    }
+}
+
+// Gray level Renderer::drawField writes for a value
+int grayLevel(double value, double maxValue) {
+    return static_cast<unsigned char>(value * (255.0 / maxValue)) / 4;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: field_accuracy <properties.txt> [tolerance] [samples]" << std::endl;
+        return 2;
+    }
+    double tolerance = argc > 2 ? std::stod(argv[2]) : 1e-3;
+    long long samples = argc > 3 ? std::max(1LL, std::stoll(argv[3])) : 10;
+
+    if (!readSettingsFromFile(argv[1], TIME_SCALE, k)) return 2;
+    if (SEED == 0) {
+        std::cerr << "accuracy runs need a fixed SEED in " << argv[1] << std::endl;
+        return 2;
+    }
+    long long steps = STEPS > 0 ? static_cast<long long>(STEPS) : 100;
+    long long interval = std::max(1LL, steps / samples);
+
+    seedRandom(static_cast<unsigned int>(SEED));
+    ParticleSystem particles;
+    spawnParticles(particles);
+
+    unsigned int width = static_cast<unsigned int>(GRID_WIDTH);
+    unsigned int height = static_cast<unsigned int>(GRID_HEIGHT);
+    FieldGrid grid(width, height, GRID_SCALE);
+    BasicFieldGrid<double> reference(width, height, GRID_SCALE);
+    BasicFieldGrid<float> single(width, height, GRID_SCALE);
+    QuadTree qtree(Boundary(0, 0, grid.worldWidth(), grid.worldHeight()));
+    ThreadPool pool(static_cast<size_t>(THREADS));
+    FieldGenerator field, referenceField, singleField;
+    Telemetry telemetry;  // not started
+    StepClock clock;
+    bool separable = SEPARABLE_FIELD == 1;
+
+    double worstField = 0.0, worstGradient = 0.0;
+    long long worstStep = 0;
+    long long doubleTotal = 0, floatTotal = 0;
+    long long pixelsOffTotal = 0;
+    int worstLevel = 0;
+
+    std::cout << "step;double_us;float_us;speedup;max_field_error;pixels_off;max_level_diff;max_gradient_error" << std::endl;
+    for (long long step = 0; step < steps; ++step) {
+        clock.beginStep();
+        generateData(clock.t, grid, particles, qtree, field, pool, telemetry, clock.tk, false);
+        clock.endStep();
+        if ((step + 1) % interval != 0) continue;
+
+        // Whole grid both times, the same work a frame after a big move costs
+        referenceField.invalidate();
+        Timer doubleTimer;
+        referenceField.generate(reference, particles, RENDER_GRAVITY_RADIUS, separable, clock.t, 0.0, pool);
+        long long doubleTime = doubleTimer.elapsed();
+        singleField.invalidate();
+        Timer floatTimer;
+        singleField.generate(single, particles, RENDER_GRAVITY_RADIUS, separable, clock.t, 0.0, pool);
+        long long floatTime = floatTimer.elapsed();
+        doubleTotal += doubleTime;
+        floatTotal += floatTime;
+
+        double referenceMax = referenceField.maxValue();
+        double singleMax = singleField.maxValue();
+        double fieldError = 0.0;
+        long long pixelsOff = 0;
+        int levelDiff = 0;
+        for (size_t p = 0; p < reference.size(); ++p) {
+            double error = std::abs(static_cast<double>(single.data()[p]) - reference.data()[p]);
+            if (!(error <= fieldError)) fieldError = error;  // NaN sticks
+            if (referenceMax > 0.0 && singleMax > 0.0) {
+                int diff = std::abs(grayLevel(single.data()[p], singleMax) - grayLevel(reference.data()[p], referenceMax));
+                if (diff > 0) ++pixelsOff;
+                levelDiff = std::max(levelDiff, diff);
+            }
+        }
+        if (referenceMax > 0.0) fieldError /= referenceMax;
+
+        double gradientError = 0.0;
+        double largestGradient = 0.0;
+        for (size_t p = 0; p < particles.size(); ++p) {
+            double dx, dy, fx, fy;
+            gridGradient(reference, particles.x[p], particles.y[p], dx, dy);
+            gridGradient(single, particles.x[p], particles.y[p], fx, fy);
+            largestGradient = std::max(largestGradient, std::hypot(dx, dy));
+            double error = std::hypot(fx - dx, fy - dy);
+            if (!(error <= gradientError)) gradientError = error;
+        }
+        if (largestGradient > 0.0) gradientError /= largestGradient;
+
+        std::cout << step << ";" << doubleTime << ";" << floatTime << ";"
+                  << (floatTime > 0 ? static_cast<double>(doubleTime) / floatTime : 0.0) << ";"
+                  << fieldError << ";" << pixelsOff << ";" << levelDiff << ";" << gradientError << std::endl;
+
+        if (!(std::max(fieldError, gradientError) <= std::max(worstField, worstGradient))) worstStep = step;
+        if (!(fieldError <= worstField)) worstField = fieldError;
+        if (!(gradientError <= worstGradient)) worstGradient = gradientError;
+        pixelsOffTotal += pixelsOff;
+        worstLevel = std::max(worstLevel, levelDiff);
+    }
+
+    bool pass = worstField <= tolerance && worstGradient <= tolerance;
+    std::cerr << (pass ? "PASS" : "FAIL") << ": float field error " << worstField << ", gradient error " << worstGradient
+              << " (worst at step " << worstStep << "), " << pixelsOffTotal << " pixels off by up to " << worstLevel
+              << " gray levels, float " << (floatTotal > 0 ? static_cast<double>(doubleTotal) / floatTotal : 0.0)
+              << "x the double speed, tolerance " << tolerance << std::endl;
+    return pass ? 0 : 1;
+}
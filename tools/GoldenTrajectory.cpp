@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Settings.h"
+#include "Simulation.h"
+#include "Random.h"
+
+// Golden-trajectory regression harness: runs the simulation headless from a fixed SEED and either records
+// x, y, vx, vy of every particle after every step, or replays it and compares against a recorded file.
+// Usage: golden_trajectory record  <properties.txt> <golden file>
+//        golden_trajectory compare <properties.txt> <golden file> [tolerance, default 1e-9]
+// compare prints step;max_error per step (|a - b| / max(1, |b|) over all particles), exits 1 past the tolerance.
+
+namespace {
+
+struct GoldenHeader {
+    char magic[8];           // "GRAVGLD\0"
+    std::uint32_t version;
+    std::uint32_t particles;
+    std::uint64_t steps;
+    std::uint64_t seed;
+};
+
+const std::uint32_t GOLDEN_VERSION = 1;
+const long long DEFAULT_STEPS = 100;
+
+void snapshot(const ParticleSystem& particles, std::vector<double>& state) {
+    state.clear();
+    for (size_t p = 0; p < particles.size(); ++p) {
+        state.push_back(particles.x[p]);
+        state.push_back(particles.y[p]);
+        state.push_back(particles.vx[p]);
+        state.push_back(particles.vy[p]);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4 || (std::string(argv[1]) != "record" && std::string(argv[1]) != "compare")) {
+        std::cerr << "Usage: golden_trajectory record|compare <properties.txt> <golden file> [tolerance]" << std::endl;
+        return 2;
+    }
+    bool recording = std::string(argv[1]) == "record";
+    double tolerance = argc > 4 ? std::stod(argv[4]) : 1e-9;
+
+    if (!readSettingsFromFile(argv[2], TIME_SCALE, k)) return 2;
+    if (SEED == 0) {
+        std::cerr << "golden runs need a fixed SEED in " << argv[2] << std::endl;
+        return 2;
+    }
+    long long steps = STEPS > 0 ? static_cast<long long>(STEPS) : DEFAULT_STEPS;
+
+    seedRandom(static_cast<unsigned int>(SEED));
+    ParticleSystem particles;
+    spawnParticles(particles);
+
+    GoldenHeader header = {};
+    std::FILE* file = std::fopen(argv[3], recording ? "wb" : "rb");
+    if (file == nullptr) {
+        std::cerr << "Failed to open golden file " << argv[3] << std::endl;
+        return 2;
+    }
+
+    if (recording) {
+        std::memcpy(header.magic, "GRAVGLD", 8);
+        header.version = GOLDEN_VERSION;
+        header.particles = static_cast<std::uint32_t>(particles.size());
+        header.steps = static_cast<std::uint64_t>(steps);
+        header.seed = static_cast<std::uint64_t>(SEED);
+        std::fwrite(&header, sizeof(header), 1, file);
+    } else {
+        if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "GRAVGLD", 8) != 0 || header.version != GOLDEN_VERSION) {
+            std::cerr << argv[3] << " is not a golden trajectory file" << std::endl;
+            return 2;
+        }
+        if (header.particles != particles.size() || header.seed != static_cast<std::uint64_t>(SEED)) {
+            std::cerr << "Golden file was recorded with " << header.particles << " particles and SEED=" << header.seed
+                      << ", settings give " << particles.size() << " and SEED=" << static_cast<std::uint64_t>(SEED) << std::endl;
+            return 2;
+        }
+        steps = std::min(steps, static_cast<long long>(header.steps));
+    }
+
+    FieldGrid grid(static_cast<unsigned int>(GRID_WIDTH), static_cast<unsigned int>(GRID_HEIGHT), GRID_SCALE);
+    QuadTree qtree(Boundary(0, 0, grid.worldWidth(), grid.worldHeight()));
+    ThreadPool pool(static_cast<size_t>(THREADS));
+    FieldGenerator field;
+    Telemetry telemetry;  // not started
+    StepClock clock;
+
+    std::vector<double> state;
+    std::vector<double> golden(particles.size() * 4);
+    double worstError = 0.0;
+    long long worstStep = 0;
+    long long firstFailure = -1;
+
+    if (!recording) std::cout << "step;max_error" << std::endl;
+    for (long long step = 0; step < steps; ++step) {
+        clock.beginStep();
+        generateData(clock.t, grid, particles, qtree, field, pool, telemetry, clock.tk, false);  // only positions are compared
+        clock.endStep();
+        snapshot(particles, state);
+
+        if (recording) {
+            std::fwrite(state.data(), sizeof(double), state.size(), file);
+            continue;
+        }
+
+        if (std::fread(golden.data(), sizeof(double), golden.size(), file) != golden.size()) {
+            std::cerr << "Golden file ends at step " << step << std::endl;
+            break;
+        }
+        double maxError = 0.0;
+        for (size_t v = 0; v < state.size(); ++v) {
+            double error = std::abs(state[v] - golden[v]) / std::max(1.0, std::abs(golden[v]));
+            if (!(error <= maxError)) maxError = error;  // NaN sticks
+        }
+        std::cout << step << ";" << maxError << std::endl;
+
+        if (!(maxError <= worstError)) {
+            worstError = maxError;
+            worstStep = step;
+        }
+        if (firstFailure < 0 && !(maxError <= tolerance)) firstFailure = step;
+    }
+    std::fclose(file);
+
+    if (recording) {
+        std::cerr << "Recorded " << steps << " steps of " << particles.size() << " particles to " << argv[3] << std::endl;
+        return 0;
+    }
+    std::cerr << (firstFailure < 0 ? "PASS" : "FAIL") << ": max error " << worstError << " at step " << worstStep
+              << ", tolerance " << tolerance;
+    if (firstFailure >= 0) std::cerr << ", first exceeded at step " << firstFailure;
+    std::cerr << std::endl;
+    return firstFailure < 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Telemetry.h"
+
+// Converts a telemetry file written by the simulation into comma separated CSV, header row first.
+// Usage: telemetry_to_csv telemetry.bin [interactions|steps]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: telemetry_to_csv <telemetry file> [interactions|steps]" << std::endl;
+        return 1;
+    }
+
+    int onlyChannel = -1;
+    if (argc > 2) {
+        std::string channel = argv[2];
+        if (channel == "interactions") onlyChannel = CHANNEL_INTERACTIONS;
+        else if (channel == "steps") onlyChannel = CHANNEL_STEPS;
+        else {
+            std::cerr << "Unknown channel " << channel << std::endl;
+            return 1;
+        }
+    }
+
+    std::FILE* file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    TelemetryFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "GRAVTLM", 8) != 0 ||
+        header.version != TELEMETRY_VERSION || header.recordSize != sizeof(TelemetryRecord)) {
+        std::cerr << "Not a telemetry file (or a different version): " << argv[1] << std::endl;
+        std::fclose(file);
+        return 1;
+    }
+
+    // Same columns as the old std::cout log for interactions, kept first
+    if (onlyChannel == CHANNEL_INTERACTIONS) {
+        std::cout << "magnitude,type,tk,particle" << std::endl;
+    } else if (onlyChannel == CHANNEL_STEPS) {
+        std::cout << "step_us,particles,tk,step" << std::endl;
+    } else {
+        std::cout << "channel,value,tag,tk,particle" << std::endl;
+    }
+
+    TelemetryRecord records[4096];
+    size_t count;
+    while ((count = std::fread(records, sizeof(TelemetryRecord), 4096, file)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            const TelemetryRecord& record = records[i];
+            if (onlyChannel >= 0) {
+                if (static_cast<int>(record.channel) != onlyChannel) continue;
+            } else {
+                std::cout << (record.channel == CHANNEL_INTERACTIONS ? "interactions" : "steps") << ",";
+            }
+            std::cout << record.value << "," << record.tag << "," << record.tk << "," << record.particle << "\n";
+        }
+    }
+
+    std::fclose(file);
+    return 0;
+}